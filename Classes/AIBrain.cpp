@@ -2,8 +2,9 @@
 
 USING_NS_CC;
 
-AIBrain::AIBrain(Difficulty difficulty) 
+AIBrain::AIBrain(Difficulty difficulty, RandomStream& random) 
     : _difficulty(difficulty)
+    , _random(random)
     , _state(State::TRANSITION)
     , _reactionTimer(0.0f)
     , _stealTimer(0.0f)
@@ -157,7 +158,7 @@ void AIBrain::processOffense(const InputData& input) {
 
     float distToOpponent = getDistance2D(input.selfPos, input.opponentPos);
     float shootDistance = 2.5f;
-    bool canShoot = distToOpponent > shootDistance;
+    bool canShoot = distToOpponent > shootDistance && input.shotLaneOpen;
 
     // Shot Clock Panic
     // If shot clock is running out (< 4 seconds), force action
@@ -273,7 +274,7 @@ void AIBrain::processDefense(const InputData& input) {
              if (_difficulty == Difficulty::EASY) baseDelay = 0.4f;
              else if (_difficulty == Difficulty::HARD) baseDelay = 0.15f; // Even hard AI has limit
              
-             _defenseReactionTimer = baseDelay + CCRANDOM_0_1() * 0.15f;
+             _defenseReactionTimer = baseDelay + _random.nextFloat() * 0.15f;
         }
         
         if (_isReactingToShot) {
@@ -292,7 +293,7 @@ void AIBrain::processDefense(const InputData& input) {
                      // Distance modifier: if very close, more likely to jump
                      if (distToOpponent < 0.8f) jumpChance += 0.2f;
                      
-                     if (CCRANDOM_0_1() < jumpChance) {
+                     if (_random.nextFloat() < jumpChance) {
                          _output.jump = true;
                          _hasJumpedForShot = true;
                      } else {
@@ -315,7 +316,7 @@ void AIBrain::processDefense(const InputData& input) {
     // 4. Steal Logic
     if (distToOpponent < 1.5f && !input.opponentIsShooting && _stealTimer <= 0) {
         // Attempt steal if opponent is vulnerable or randomly
-        float roll = CCRANDOM_0_1();
+        float roll = _random.nextFloat();
         float threshold = 0.005f; // Low chance per frame
         if (_difficulty == Difficulty::HARD) threshold = 0.02f;
         
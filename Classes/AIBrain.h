@@ -2,6 +2,7 @@
 #define __AI_BRAIN_H__
 
 #include "cocos2d.h"
+#include "MatchRandom.h"
 
 class AIBrain {
 public:
@@ -26,6 +27,7 @@ public:
         bool hasBall;
         bool opponentHasBall;
         bool opponentIsShooting; 
+        bool shotLaneOpen; // Nobody in the way to the hoop within contest range
         bool needsClear; // Added for 3-point clear rule
         float dt;
         float shotClock; // Added shot clock awareness
@@ -51,7 +53,7 @@ public:
         }
     };
 
-    AIBrain(Difficulty difficulty);
+    AIBrain(Difficulty difficulty, RandomStream& random);
     ~AIBrain();
 
     void update(const InputData& input);
@@ -60,6 +62,7 @@ public:
 
 private:
     Difficulty _difficulty;
+    RandomStream& _random;
     State _state;
     OutputData _output;
     
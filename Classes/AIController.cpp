@@ -3,9 +3,17 @@
 #include "Basketball.h"
 #include "SimplePhysics.h"
 #include "ScoreManager.h"
+#include "MatchManager.h"
+#include "CollisionSystem.h"
+#include <algorithm>
 
 USING_NS_CC;
 
+// Shot lane: a player within this distance on the way to the hoop
+// contests the shot. Radius plus a player's radius is the lane's half width.
+static const float SHOT_LANE_RANGE = 3.5f;
+static const float SHOT_LANE_RADIUS = 0.3f;
+
 AIController::AIController(Player* opponent, Basketball* ball, AIBrain::Difficulty difficulty)
     : _opponent(opponent)
     , _ball(ball)
@@ -17,7 +25,7 @@ AIController::AIController(Player* opponent, Basketball* ball, AIBrain::Difficul
     , _defend(false)
     , _crossover(false)
 {
-    _brain = new AIBrain(difficulty);
+    _brain = new AIBrain(difficulty, MatchManager::getInstance()->getRandom().ai());
 }
 
 AIController::~AIController() {
@@ -41,6 +49,18 @@ void AIController::update(float dt) {
     input.hasBall = _player->hasBall();
     input.opponentHasBall = _opponent->hasBall();
     input.opponentIsShooting = (_opponent->getState() == Player::State::SHOOTING);
+    
+    // The cast starts inside our own capsule, which queries skip
+    input.shotLaneOpen = true;
+    CollisionSystem* world = _player->getWorld();
+    Vec3 toHoop = input.hoopPos - input.selfPos;
+    toHoop.y = 0;
+    float hoopDist = toHoop.length();
+    if (world && hoopDist > 0.1f) {
+        CollisionSystem::RaycastHit hit;
+        input.shotLaneOpen = !world->sphereCast(input.selfPos, toHoop, SHOT_LANE_RADIUS,
+                                                std::min(hoopDist, SHOT_LANE_RANGE), hit, SimplePhysics::MASK_PLAYER);
+    }
     input.needsClear = _player->mustClearBall();
     input.dt = dt;
     input.shotClock = ScoreManager::getInstance()->getShotClock();
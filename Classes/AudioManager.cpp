@@ -36,11 +36,13 @@ AudioManager::~AudioManager() {
 }
 
 void AudioManager::init() {
+#if !NBA2K_HEADLESS
     // Preload music to ensure it's ready
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename("music.ogg");
     if (!fullPath.empty()) {
         SimpleAudioEngine::getInstance()->preloadBackgroundMusic(fullPath.c_str());
     }
+#endif
 }
 
 void AudioManager::playBackgroundMusic(const std::string& filename, bool loop) {
@@ -66,9 +68,13 @@ void AudioManager::setBackgroundMusicVolume(float volume) {
 }
 
 unsigned int AudioManager::playEffect(const std::string& filename, bool loop, float pitch, float pan, float gain) {
+#if NBA2K_HEADLESS
+    return 0; // No audio device in the headless simulation
+#else
     // Check limit? SimpleAudioEngine usually handles max instances (32 default on windows)
     // We can just play.
     return SimpleAudioEngine::getInstance()->playEffect(filename.c_str(), loop, pitch, pan, gain * _sfxVolume * _masterVolume);
+#endif
 }
 
 void AudioManager::stopEffect(unsigned int soundId) {
@@ -9,8 +9,12 @@
 USING_NS_CC;
 
 Basketball* Basketball::create() {
+    return create(CollisionSystem::getInstance());
+}
+
+Basketball* Basketball::create(CollisionSystem* world) {
     Basketball* pRet = new (std::nothrow) Basketball();
-    if (pRet && pRet->init()) {
+    if (pRet && pRet->init(world)) {
         pRet->autorelease();
         return pRet;
     }
@@ -22,13 +26,19 @@ Basketball* Basketball::create() {
 }
 
 bool Basketball::init() {
+    return init(CollisionSystem::getInstance());
+}
+
+bool Basketball::init(CollisionSystem* world) {
     if (!Node::init()) return false;
     
     _state = State::NONE;
     _owner = nullptr;
     _dribbleTimer = 0.0f;
     _dribbleDown = true;
+    _visual = nullptr;
     
+#if !NBA2K_HEADLESS
     // Visuals
     _visual = Sprite3D::create("basketball.c3b");
     if (_visual) {
@@ -62,6 +72,7 @@ bool Basketball::init() {
             addChild(_visual);
         }
     }
+#endif
     
     // Physics
     _body = new RigidBody(ColliderType::SPHERE, SimplePhysics::MASK_BALL, SimplePhysics::MASK_FLOOR | SimplePhysics::MASK_PLAYER | SimplePhysics::MASK_HOOP);
@@ -69,13 +80,17 @@ bool Basketball::init() {
     _body->setMass(0.6f); // 0.6kg
     _body->setMaterial(SimplePhysicsMaterial(0.8f, 0.5f)); // High bounce, medium friction
     _body->setUserData(this);
+    _body->setNode(this);
     
-    CollisionSystem::getInstance()->addBody(_body);
+    world->addBody(_body);
 
+    // Contacts while HELD or DRIBBLING (kinematic) are never dispatched: that
+    // is decided when the contact is resolved, not from _state after the frame.
     _body->onCollision = [this](RigidBody* other, float impulse) {
-        if (_state == State::HELD || _state == State::DRIBBLING) return;
-        
-        // Threshold to avoid sliding sounds
+        // Threshold to avoid sliding sounds. The solver's accumulated impulse
+        // is (1 + e) * m * v for an impact, as the one-shot impulse was, so
+        // 1.0 is still a hit of about 1 m/s; a ball rolling or resting on
+        // something carries m * g * dt (0.1) per step, well below it.
         if (impulse < 1.0f) return;
         
         int mask = other->getCategoryMask();
@@ -87,7 +102,9 @@ bool Basketball::init() {
         }
     };
     
-    scheduleUpdate();
+#if !NBA2K_DETERMINISTIC
+    scheduleUpdate(); // Deterministic builds step the ball in BasketballScene::tick
+#endif
     
     return true;
 }
@@ -119,6 +136,7 @@ Vec3 Basketball::getVelocity() const {
 
 void Basketball::setState(State state) {
     _state = state;
+    if (_body) _body->wakeUp();
     
     if (_state == State::HELD || _state == State::DRIBBLING) {
         if (_body) _body->setKinematic(true);
@@ -130,8 +148,7 @@ void Basketball::setState(State state) {
 void Basketball::update(float dt) {
     if (_state == State::FLYING || _state == State::ON_GROUND) {
         if (_body) {
-            float alpha = CollisionSystem::getInstance()->getAlpha();
-            Node::setPosition3D(_body->getInterpolatedPosition(alpha));
+            // The node follows the body through CollisionSystem::syncNodes
             
             // Check if on ground
             if (_body->getPosition().y <= RADIUS + 0.05f && _body->getVelocity().lengthSquared() < 0.1f) {
@@ -258,4 +275,18 @@ void Basketball::hold(const Vec3& holdPos) {
     
     setPosition3D(holdPos);
     if (_body) _body->setVelocity(Vec3::ZERO);
-}
\ No newline at end of file
+}
+
+void Basketball::snapshot(Snapshot& out) const {
+    out.state = _state;
+    out.owner = _owner;
+    out.dribbleTimer = _dribbleTimer;
+    out.dribbleDown = _dribbleDown;
+}
+
+void Basketball::restore(const Snapshot& snapshot) {
+    setState(snapshot.state); // Sets the body kinematic to match
+    _owner = snapshot.owner;
+    _dribbleTimer = snapshot.dribbleTimer;
+    _dribbleDown = snapshot.dribbleDown;
+}
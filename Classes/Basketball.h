@@ -5,11 +5,14 @@
 #include "RigidBody.h"
 
 class Player;
+class CollisionSystem;
 
 class Basketball : public cocos2d::Node {
 public:
     static Basketball* create();
+    static Basketball* create(CollisionSystem* world);
     virtual bool init() override;
+    bool init(CollisionSystem* world);
     
     // Core Logic
     void update(float dt) override;
@@ -42,6 +45,16 @@ public:
     void setOwner(Player* player) { _owner = player; }
     Player* getOwner() const { return _owner; }
 
+    // For replay keyframes; restore the world after the ball
+    struct Snapshot {
+        State state;
+        Player* owner;
+        float dribbleTimer;
+        bool dribbleDown;
+    };
+    void snapshot(Snapshot& out) const;
+    void restore(const Snapshot& snapshot);
+
     // Visuals
     void updateRotation(float dt);
 
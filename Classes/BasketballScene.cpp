@@ -14,9 +14,15 @@
 #include "MatchManager.h"
 #include "GameIntegrator.h"
 #include "Hoop.h"
+#include "DeterministicMath.h"
+#include "SaveSystem.h"
+#include "StateHash.h"
+#include <random>
 
 USING_NS_CC;
 
+const char* BasketballScene::REPLAY_FILE = "last_match.nbr";
+
 Scene* BasketballScene::createScene() {
     return BasketballScene::create();
 }
@@ -24,6 +30,12 @@ Scene* BasketballScene::createScene() {
 bool BasketballScene::init() {
     if (!Scene::init()) return false;
     
+    _tickAccumulator = 0.0f;
+    _playerRecorder = nullptr;
+    _aiRecorder = nullptr;
+    _tickCount = 0;
+    _isRecording = false;
+    
     // Initialize Systems
     GameCore::getInstance()->initPrimitives();
     CollisionSystem::getInstance()->reset();
@@ -37,6 +49,8 @@ bool BasketballScene::init() {
     
     // Init Managers
     GameFlow::getInstance()->reset();
+    uint64_t seed = std::random_device()(); // A fresh match every time
+    MatchManager::getInstance()->seedRandom(seed);
     
     // Lights
     auto ambientLight = AmbientLight::create(Color3B(100, 100, 100));
@@ -54,6 +68,13 @@ bool BasketballScene::init() {
     MatchManager::getInstance()->init(_player, _aiPlayer, _ball);
     MatchManager::getInstance()->startMatch(); // Start with Jump Ball
     
+#if NBA2K_DETERMINISTIC
+    // A resumed match starts from the save file, which the log can't replay
+    if (!SaveSystem::getInstance()->getMatchProgress().hasSavedMatch) {
+        startRecording(seed);
+    }
+#endif
+    
     createUI();
     
     // Initialize Visual Managers
@@ -278,6 +299,19 @@ void BasketballScene::update(float dt) {
     // Global Integrator
     GameIntegrator::getInstance()->update(dt);
     
+#if NBA2K_DETERMINISTIC
+    // Gameplay advances in whole ticks whatever the frame rate (clamped
+    // like CollisionSystem's accumulator after a hitch)
+    _tickAccumulator += dt;
+    if (_tickAccumulator > 0.2f) _tickAccumulator = 0.2f;
+    while (_tickAccumulator >= SimplePhysics::FIXED_TIME_STEP) {
+        tick();
+        _tickAccumulator -= SimplePhysics::FIXED_TIME_STEP;
+    }
+    
+    // Update Effects
+    EffectsManager::getInstance()->update(dt);
+#else
     // Global Flow Update
     GameFlow::getInstance()->update(dt);
     MatchManager::getInstance()->update(dt);
@@ -293,6 +327,7 @@ void BasketballScene::update(float dt) {
     if (_gameRules) {
         _gameRules->update(dt);
     }
+#endif
     
     updateUI();
     
@@ -302,6 +337,69 @@ void BasketballScene::update(float dt) {
     }
 }
 
+void BasketballScene::tick() {
+    const float dt = SimplePhysics::FIXED_TIME_STEP;
+    DeterministicMath::FloatModeScope floatMode;
+    
+    // Players and ball aren't scheduled in deterministic builds
+    if (_player) _player->update(dt);
+    if (_aiPlayer) _aiPlayer->update(dt);
+    if (_ball) _ball->update(dt);
+    
+    GameFlow::getInstance()->update(dt);
+    MatchManager::getInstance()->update(dt);
+    CollisionSystem::getInstance()->update(dt);
+    if (_gameRules) {
+        _gameRules->update(dt);
+    }
+    
+    if (_isRecording) {
+        _tickCount++;
+        if (_tickCount % InputLog::CHECKPOINT_INTERVAL == 0) {
+            // Same hash as HeadlessMatch::getTickHash
+            StateHash hash;
+            CollisionSystem::getInstance()->hashState(hash);
+            MatchManager::getInstance()->hashState(hash);
+            _inputLog.addCheckpoint(_tickCount, hash.get());
+        }
+        if (GameFlow::getInstance()->getState() != GameFlow::State::PLAYING) {
+            saveRecording();
+        }
+    }
+}
+
+void BasketballScene::startRecording(uint64_t seed) {
+    _inputLog.clear();
+    _inputLog.setSeed(seed);
+    _inputLog.setLineup(InputLog::HOME, InputLog::Lineup()); // Default stats
+    _inputLog.setLineup(InputLog::AWAY, InputLog::Lineup(35.0f, 50.0f, 50.0f));
+    
+    _playerRecorder = new RecordingController(_playerController, &_inputLog, InputLog::HOME);
+    _player->setController(_playerRecorder);
+    _aiRecorder = new RecordingController(_aiController, &_inputLog, InputLog::AWAY);
+    _aiPlayer->setController(_aiRecorder);
+    
+    _tickCount = 0;
+    _isRecording = true;
+}
+
+void BasketballScene::saveRecording() {
+    if (!_isRecording) return;
+    _isRecording = false;
+    
+    std::string path = FileUtils::getInstance()->getWritablePath() + REPLAY_FILE;
+    if (_inputLog.save(path)) {
+        CCLOG("Saved replay (%u ticks, %zu bytes) to %s", _inputLog.getTickCount(), _inputLog.getSize(), path.c_str());
+    } else {
+        CCLOG("Failed to save replay to %s", path.c_str());
+    }
+}
+
+void BasketballScene::onExit() {
+    saveRecording();
+    Scene::onExit();
+}
+
 void BasketballScene::createUI() {
     _gameUI = GameUI::create();
     if (_gameUI) {
@@ -9,6 +9,8 @@
 #include "GameRules.h"
 #include "ScoreManager.h"
 #include "GameUI.h"
+#include "InputLog.h"
+#include "RecordingController.h"
 
 class BasketballScene : public cocos2d::Scene {
 public:
@@ -18,8 +20,28 @@ public:
     CREATE_FUNC(BasketballScene);
     
     virtual void update(float dt) override;
+    virtual void onExit() override;
+    
+    static const char* REPLAY_FILE; // In the writable path
     
 private:
+    // One fixed gameplay step, in the same order as HeadlessMatch::step.
+    // NBA2K_DETERMINISTIC builds run gameplay only through this, so it never
+    // sees the render frame's dt.
+    void tick();
+    float _tickAccumulator;
+    
+    // NBA2K_DETERMINISTIC builds record every fresh match's input and save
+    // it to REPLAY_FILE when the match ends, is paused (the pause menu isn't
+    // part of the log) or the scene exits. nba2k_sim --replay plays it back.
+    void startRecording(uint64_t seed);
+    void saveRecording();
+    InputLog _inputLog;
+    RecordingController* _playerRecorder;
+    RecordingController* _aiRecorder;
+    uint32_t _tickCount;
+    bool _isRecording;
+
     void createCourt();
     void createPlayer();
     void createBall();
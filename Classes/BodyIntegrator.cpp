@@ -0,0 +1,227 @@
+#include "BodyIntegrator.h"
+#include "SimplePhysics.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BODY_INTEGRATOR_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BODY_INTEGRATOR_SSE2 1
+#endif
+
+namespace {
+
+struct Streams {
+    float* posX; float* posY; float* posZ;
+    float* prevX; float* prevY; float* prevZ;
+    float* velX; float* velY; float* velZ;
+    float* forceX; float* forceY; float* forceZ;
+    const float* invMass;
+    const float* dynamicMask;
+    const float* movableMask;
+    const float* floorLevel;
+    const float* floorBounce;
+    const float* floorFriction;
+};
+
+// Reference kernel. The SIMD paths below mirror it operation for operation.
+inline void integrateOne(const Streams& s, size_t i, float dt) {
+    const float gravity = SimplePhysics::GRAVITY;
+    float invMass = s.invMass[i];
+    float dyn = s.dynamicMask[i];
+    float mov = s.movableMask[i];
+
+    // v += (f/m + g) * dt, masked off for static / kinematic bodies
+    float vx = s.velX[i] + ((s.forceX[i] * invMass) * dt) * dyn;
+    float vy = s.velY[i] + ((s.forceY[i] * invMass + gravity) * dt) * dyn;
+    float vz = s.velZ[i] + ((s.forceZ[i] * invMass) * dt) * dyn;
+
+    float px = s.posX[i];
+    float py = s.posY[i];
+    float pz = s.posZ[i];
+    s.prevX[i] = px;
+    s.prevY[i] = py;
+    s.prevZ[i] = pz;
+
+    // x += v * dt, masked off for static bodies
+    px += (vx * dt) * mov;
+    py += (vy * dt) * mov;
+    pz += (vz * dt) * mov;
+
+    // Floor: clamp position, and on downward contact scale velocity
+    // (slow contacts come to rest instead of bouncing)
+    float level = s.floorLevel[i];
+    bool below = py < level;
+    bool bounce = below && vy < 0.0f;
+    py = below ? level : py;
+    float friction = s.floorFriction[i];
+    float factor = vy < -SimplePhysics::RESTITUTION_VELOCITY ? s.floorBounce[i] : 0.0f;
+    vy = bounce ? vy * factor : vy;
+    vx = bounce ? vx * friction : vx;
+    vz = bounce ? vz * friction : vz;
+
+    s.posX[i] = px; s.posY[i] = py; s.posZ[i] = pz;
+    s.velX[i] = vx; s.velY[i] = vy; s.velZ[i] = vz;
+    s.forceX[i] = 0.0f; s.forceY[i] = 0.0f; s.forceZ[i] = 0.0f;
+}
+
+#if defined(BODY_INTEGRATOR_AVX2)
+
+size_t integrateWide(const Streams& s, size_t count, float dt) {
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 vgravity = _mm256_set1_ps(SimplePhysics::GRAVITY);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 vrest = _mm256_set1_ps(-SimplePhysics::RESTITUTION_VELOCITY);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 invMass = _mm256_loadu_ps(s.invMass + i);
+        __m256 dyn = _mm256_loadu_ps(s.dynamicMask + i);
+        __m256 mov = _mm256_loadu_ps(s.movableMask + i);
+
+        __m256 ax = _mm256_mul_ps(_mm256_loadu_ps(s.forceX + i), invMass);
+        __m256 ay = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s.forceY + i), invMass), vgravity);
+        __m256 az = _mm256_mul_ps(_mm256_loadu_ps(s.forceZ + i), invMass);
+        __m256 vx = _mm256_add_ps(_mm256_loadu_ps(s.velX + i), _mm256_mul_ps(_mm256_mul_ps(ax, vdt), dyn));
+        __m256 vy = _mm256_add_ps(_mm256_loadu_ps(s.velY + i), _mm256_mul_ps(_mm256_mul_ps(ay, vdt), dyn));
+        __m256 vz = _mm256_add_ps(_mm256_loadu_ps(s.velZ + i), _mm256_mul_ps(_mm256_mul_ps(az, vdt), dyn));
+
+        __m256 px = _mm256_loadu_ps(s.posX + i);
+        __m256 py = _mm256_loadu_ps(s.posY + i);
+        __m256 pz = _mm256_loadu_ps(s.posZ + i);
+        _mm256_storeu_ps(s.prevX + i, px);
+        _mm256_storeu_ps(s.prevY + i, py);
+        _mm256_storeu_ps(s.prevZ + i, pz);
+
+        px = _mm256_add_ps(px, _mm256_mul_ps(_mm256_mul_ps(vx, vdt), mov));
+        py = _mm256_add_ps(py, _mm256_mul_ps(_mm256_mul_ps(vy, vdt), mov));
+        pz = _mm256_add_ps(pz, _mm256_mul_ps(_mm256_mul_ps(vz, vdt), mov));
+
+        __m256 level = _mm256_loadu_ps(s.floorLevel + i);
+        __m256 below = _mm256_cmp_ps(py, level, _CMP_LT_OQ);
+        __m256 bounce = _mm256_and_ps(below, _mm256_cmp_ps(vy, zero, _CMP_LT_OQ));
+        py = _mm256_blendv_ps(py, level, below);
+        __m256 friction = _mm256_loadu_ps(s.floorFriction + i);
+        __m256 factor = _mm256_and_ps(_mm256_loadu_ps(s.floorBounce + i), _mm256_cmp_ps(vy, vrest, _CMP_LT_OQ));
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(vy, factor), bounce);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(vx, friction), bounce);
+        vz = _mm256_blendv_ps(vz, _mm256_mul_ps(vz, friction), bounce);
+
+        _mm256_storeu_ps(s.posX + i, px);
+        _mm256_storeu_ps(s.posY + i, py);
+        _mm256_storeu_ps(s.posZ + i, pz);
+        _mm256_storeu_ps(s.velX + i, vx);
+        _mm256_storeu_ps(s.velY + i, vy);
+        _mm256_storeu_ps(s.velZ + i, vz);
+        _mm256_storeu_ps(s.forceX + i, zero);
+        _mm256_storeu_ps(s.forceY + i, zero);
+        _mm256_storeu_ps(s.forceZ + i, zero);
+    }
+    return i;
+}
+
+#elif defined(BODY_INTEGRATOR_SSE2)
+
+// SSE2 has no blendv; select with and/andnot/or
+inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+size_t integrateWide(const Streams& s, size_t count, float dt) {
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vgravity = _mm_set1_ps(SimplePhysics::GRAVITY);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 vrest = _mm_set1_ps(-SimplePhysics::RESTITUTION_VELOCITY);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 invMass = _mm_loadu_ps(s.invMass + i);
+        __m128 dyn = _mm_loadu_ps(s.dynamicMask + i);
+        __m128 mov = _mm_loadu_ps(s.movableMask + i);
+
+        __m128 ax = _mm_mul_ps(_mm_loadu_ps(s.forceX + i), invMass);
+        __m128 ay = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s.forceY + i), invMass), vgravity);
+        __m128 az = _mm_mul_ps(_mm_loadu_ps(s.forceZ + i), invMass);
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(s.velX + i), _mm_mul_ps(_mm_mul_ps(ax, vdt), dyn));
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(s.velY + i), _mm_mul_ps(_mm_mul_ps(ay, vdt), dyn));
+        __m128 vz = _mm_add_ps(_mm_loadu_ps(s.velZ + i), _mm_mul_ps(_mm_mul_ps(az, vdt), dyn));
+
+        __m128 px = _mm_loadu_ps(s.posX + i);
+        __m128 py = _mm_loadu_ps(s.posY + i);
+        __m128 pz = _mm_loadu_ps(s.posZ + i);
+        _mm_storeu_ps(s.prevX + i, px);
+        _mm_storeu_ps(s.prevY + i, py);
+        _mm_storeu_ps(s.prevZ + i, pz);
+
+        px = _mm_add_ps(px, _mm_mul_ps(_mm_mul_ps(vx, vdt), mov));
+        py = _mm_add_ps(py, _mm_mul_ps(_mm_mul_ps(vy, vdt), mov));
+        pz = _mm_add_ps(pz, _mm_mul_ps(_mm_mul_ps(vz, vdt), mov));
+
+        __m128 level = _mm_loadu_ps(s.floorLevel + i);
+        __m128 below = _mm_cmplt_ps(py, level);
+        __m128 bounce = _mm_and_ps(below, _mm_cmplt_ps(vy, zero));
+        py = select(below, level, py);
+        __m128 friction = _mm_loadu_ps(s.floorFriction + i);
+        __m128 factor = _mm_and_ps(_mm_loadu_ps(s.floorBounce + i), _mm_cmplt_ps(vy, vrest));
+        vy = select(bounce, _mm_mul_ps(vy, factor), vy);
+        vx = select(bounce, _mm_mul_ps(vx, friction), vx);
+        vz = select(bounce, _mm_mul_ps(vz, friction), vz);
+
+        _mm_storeu_ps(s.posX + i, px);
+        _mm_storeu_ps(s.posY + i, py);
+        _mm_storeu_ps(s.posZ + i, pz);
+        _mm_storeu_ps(s.velX + i, vx);
+        _mm_storeu_ps(s.velY + i, vy);
+        _mm_storeu_ps(s.velZ + i, vz);
+        _mm_storeu_ps(s.forceX + i, zero);
+        _mm_storeu_ps(s.forceY + i, zero);
+        _mm_storeu_ps(s.forceZ + i, zero);
+    }
+    return i;
+}
+
+#else
+
+size_t integrateWide(const Streams&, size_t, float) {
+    return 0;
+}
+
+#endif
+
+} // namespace
+
+void BodyIntegrator::integrate(BodyStore& store, float dt) {
+    integrate(store, dt, 0, store.size());
+}
+
+void BodyIntegrator::integrate(BodyStore& store, float dt, size_t begin, size_t end) {
+    if (begin >= end) return;
+    const size_t count = end - begin;
+
+    Streams s;
+    s.posX = store.posX.data() + begin; s.posY = store.posY.data() + begin; s.posZ = store.posZ.data() + begin;
+    s.prevX = store.prevX.data() + begin; s.prevY = store.prevY.data() + begin; s.prevZ = store.prevZ.data() + begin;
+    s.velX = store.velX.data() + begin; s.velY = store.velY.data() + begin; s.velZ = store.velZ.data() + begin;
+    s.forceX = store.forceX.data() + begin; s.forceY = store.forceY.data() + begin; s.forceZ = store.forceZ.data() + begin;
+    s.invMass = store.invMass.data() + begin;
+    s.dynamicMask = store.dynamicMask.data() + begin;
+    s.movableMask = store.movableMask.data() + begin;
+    s.floorLevel = store.floorLevel.data() + begin;
+    s.floorBounce = store.floorBounce.data() + begin;
+    s.floorFriction = store.floorFriction.data() + begin;
+
+    size_t i = integrateWide(s, count, dt);
+    for (; i < count; ++i) {
+        integrateOne(s, i, dt);
+    }
+}
+
+const char* BodyIntegrator::getBackendName() {
+#if defined(BODY_INTEGRATOR_AVX2)
+    return "AVX2";
+#elif defined(BODY_INTEGRATOR_SSE2)
+    return "SSE2";
+#else
+    return "Scalar";
+#endif
+}
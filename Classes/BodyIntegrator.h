@@ -0,0 +1,25 @@
+#ifndef __BODY_INTEGRATOR_H__
+#define __BODY_INTEGRATOR_H__
+
+#include "BodyStore.h"
+
+// Batched symplectic Euler over a BodyStore. Processes 8 bodies per iteration
+// with AVX2, 4 with SSE2, and falls back to a scalar loop (also used for the
+// tail). Static / kinematic handling and the floor bounce / clamp are applied
+// through the store's per-body masks and coefficients, so every lane runs the
+// same instructions.
+//
+// All paths perform the same IEEE operations in the same order, so results do
+// not depend on which backend was compiled in.
+class BodyIntegrator {
+public:
+    static void integrate(BodyStore& store, float dt);
+
+    // Integrates the dense index range [begin, end) only
+    static void integrate(BodyStore& store, float dt, size_t begin, size_t end);
+
+    // "AVX2", "SSE2" or "Scalar"
+    static const char* getBackendName();
+};
+
+#endif // __BODY_INTEGRATOR_H__
@@ -0,0 +1,132 @@
+#include "BodyStore.h"
+#include <limits>
+
+BodyStore::BodyStore() : _layoutVersion(0), _staticVersion(0), _activityVersion(0) {}
+
+BodyStore::Handle BodyStore::create(RigidBody* body) {
+    Handle handle;
+    if (!_freeHandles.empty()) {
+        handle = _freeHandles.back();
+        _freeHandles.pop_back();
+    } else {
+        handle = (Handle)_handleToIndex.size();
+        _handleToIndex.push_back(0);
+    }
+
+    _handleToIndex[handle] = (uint32_t)owner.size();
+    _indexToHandle.push_back(handle);
+
+    posX.push_back(0.0f); posY.push_back(0.0f); posZ.push_back(0.0f);
+    prevX.push_back(0.0f); prevY.push_back(0.0f); prevZ.push_back(0.0f);
+    velX.push_back(0.0f); velY.push_back(0.0f); velZ.push_back(0.0f);
+    forceX.push_back(0.0f); forceY.push_back(0.0f); forceZ.push_back(0.0f);
+    invMass.push_back(0.0f);
+    radius.push_back(0.0f);
+    extentX.push_back(0.0f);
+    extentY.push_back(0.0f);
+    extentZ.push_back(0.0f);
+    restitution.push_back(0.0f);
+    flags.push_back(0);
+    sleepTimer.push_back(0.0f);
+    dynamicMask.push_back(0.0f);
+    movableMask.push_back(0.0f);
+    floorLevel.push_back(0.0f);
+    floorBounce.push_back(1.0f);
+    floorFriction.push_back(1.0f);
+    owner.push_back(body);
+    node.push_back(nullptr);
+    // Nothing written yet: NaN never compares equal, so the first sync writes
+    float unset = std::numeric_limits<float>::quiet_NaN();
+    nodeX.push_back(unset); nodeY.push_back(unset); nodeZ.push_back(unset);
+
+    _layoutVersion++;
+    return handle;
+}
+
+template <typename T>
+static void eraseAt(std::vector<T>& v, size_t index) {
+    v.erase(v.begin() + index);
+}
+
+void BodyStore::destroy(Handle handle) {
+    size_t index = _handleToIndex[handle];
+    if (flags[index] & FLAG_STATIC) _staticVersion++;
+
+    // Order-preserving erase keeps the iteration (and thus resolution) order stable.
+    // Removal is rare (scene teardown), so the shift is acceptable.
+    eraseAt(posX, index); eraseAt(posY, index); eraseAt(posZ, index);
+    eraseAt(prevX, index); eraseAt(prevY, index); eraseAt(prevZ, index);
+    eraseAt(velX, index); eraseAt(velY, index); eraseAt(velZ, index);
+    eraseAt(forceX, index); eraseAt(forceY, index); eraseAt(forceZ, index);
+    eraseAt(invMass, index);
+    eraseAt(radius, index);
+    eraseAt(extentX, index);
+    eraseAt(extentY, index);
+    eraseAt(extentZ, index);
+    eraseAt(restitution, index);
+    eraseAt(flags, index);
+    eraseAt(sleepTimer, index);
+    eraseAt(dynamicMask, index);
+    eraseAt(movableMask, index);
+    eraseAt(floorLevel, index);
+    eraseAt(floorBounce, index);
+    eraseAt(floorFriction, index);
+    eraseAt(owner, index);
+    eraseAt(node, index);
+    eraseAt(nodeX, index); eraseAt(nodeY, index); eraseAt(nodeZ, index);
+    eraseAt(_indexToHandle, index);
+
+    for (size_t i = index; i < _indexToHandle.size(); ++i) {
+        _handleToIndex[_indexToHandle[i]] = (uint32_t)i;
+    }
+
+    _handleToIndex[handle] = 0;
+    _freeHandles.push_back(handle);
+    _layoutVersion++;
+}
+
+void BodyStore::clear() {
+    posX.clear(); posY.clear(); posZ.clear();
+    prevX.clear(); prevY.clear(); prevZ.clear();
+    velX.clear(); velY.clear(); velZ.clear();
+    forceX.clear(); forceY.clear(); forceZ.clear();
+    invMass.clear();
+    radius.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+    restitution.clear();
+    flags.clear();
+    sleepTimer.clear();
+    dynamicMask.clear();
+    movableMask.clear();
+    floorLevel.clear();
+    floorBounce.clear();
+    floorFriction.clear();
+    owner.clear();
+    node.clear();
+    nodeX.clear(); nodeY.clear(); nodeZ.clear();
+    _handleToIndex.clear();
+    _indexToHandle.clear();
+    _freeHandles.clear();
+    _layoutVersion++;
+    _staticVersion++;
+}
+
+void BodyStore::sleep(size_t index) {
+    if (flags[index] & FLAG_SLEEPING) return;
+    flags[index] |= FLAG_SLEEPING;
+
+    // Come to a full stop, and stop interpolating from the last substep
+    velX[index] = 0.0f; velY[index] = 0.0f; velZ[index] = 0.0f;
+    forceX[index] = 0.0f; forceY[index] = 0.0f; forceZ[index] = 0.0f;
+    prevX[index] = posX[index]; prevY[index] = posY[index]; prevZ[index] = posZ[index];
+    _activityVersion++;
+}
+
+void BodyStore::wake(size_t index) {
+    if (!(flags[index] & FLAG_SLEEPING)) return;
+    flags[index] &= ~FLAG_SLEEPING;
+    sleepTimer[index] = 0.0f;
+    _activityVersion++;
+}
@@ -0,0 +1,91 @@
+#ifndef __BODY_STORE_H__
+#define __BODY_STORE_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class RigidBody;
+namespace cocos2d { class Node; }
+
+// Structure-of-arrays storage for the per-body state touched every substep.
+// Bodies are addressed by a stable handle; the dense arrays stay packed and
+// keep insertion order, so the integrate / boundary / broadphase passes
+// stream through contiguous memory instead of chasing RigidBody pointers.
+class BodyStore {
+public:
+    typedef uint32_t Handle;
+    static const Handle INVALID_HANDLE = 0xffffffffu;
+
+    enum Flags : uint8_t {
+        FLAG_STATIC = 1 << 0,
+        FLAG_KINEMATIC = 1 << 1,
+        FLAG_UNBOUNDED = 1 << 2,    // Plane: no finite AABB
+        FLAG_FLOOR_BOUNCE = 1 << 3, // Ball: bounces off the floor
+        FLAG_FLOOR_CLAMP = 1 << 4,  // Player: feet clamped to the floor
+        FLAG_SLEEPING = 1 << 5,     // At rest: skipped by every per-substep pass
+        FLAG_CCD = 1 << 6           // Ball: swept when moving fast
+    };
+
+    BodyStore();
+
+    Handle create(RigidBody* owner);
+    void destroy(Handle handle);
+    void clear();
+
+    size_t size() const { return owner.size(); }
+    size_t indexOf(Handle handle) const { return _handleToIndex[handle]; }
+    bool isAlive(Handle handle) const {
+        return handle < _handleToIndex.size() && _handleToIndex[handle] < _indexToHandle.size()
+            && _indexToHandle[_handleToIndex[handle]] == handle;
+    }
+
+    // Bumped whenever bodies are created or destroyed (dense indices shift)
+    uint32_t getLayoutVersion() const { return _layoutVersion; }
+
+    // Bumped whenever a static body is added, removed, moved or reshaped
+    uint32_t getStaticVersion() const { return _staticVersion; }
+    void markStaticChanged() { _staticVersion++; }
+
+    // Bumped whenever a body falls asleep or wakes up
+    uint32_t getActivityVersion() const { return _activityVersion; }
+    bool isSleeping(size_t index) const { return (flags[index] & FLAG_SLEEPING) != 0; }
+    void markActivityChanged() { _activityVersion++; }
+    void sleep(size_t index);
+    void wake(size_t index);
+
+    // Dense arrays, indexed by indexOf(handle)
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> prevX, prevY, prevZ;
+    std::vector<float> velX, velY, velZ;
+    std::vector<float> forceX, forceY, forceZ;
+    std::vector<float> invMass;
+    std::vector<float> radius;       // Sphere / capsule / torus tube radius; smallest half extent for boxes
+    std::vector<float> extentX;      // Half size of the AABB
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+    std::vector<float> restitution;
+    std::vector<uint8_t> flags;
+    std::vector<float> sleepTimer;   // Seconds spent below the sleep velocity
+
+    // Integration coefficients derived from flags, so the integrator can run
+    // branch-free over batches of bodies (see BodyIntegrator)
+    std::vector<float> dynamicMask;   // 1 if forces and gravity apply, else 0
+    std::vector<float> movableMask;   // 1 if velocity moves the body, else 0 (static)
+    std::vector<float> floorLevel;    // Lowest allowed position.y (very low if no floor handling)
+    std::vector<float> floorBounce;   // velocity.y factor on floor contact (-0.7 ball, 0 player)
+    std::vector<float> floorFriction; // velocity.xz factor on floor contact
+    std::vector<RigidBody*> owner;
+    std::vector<cocos2d::Node*> node; // Scene node following the body, or null (see CollisionSystem::syncNodes)
+    std::vector<float> nodeX, nodeY, nodeZ; // Position last written to the node
+
+private:
+    std::vector<uint32_t> _handleToIndex;
+    std::vector<Handle> _indexToHandle;
+    std::vector<Handle> _freeHandles;
+    uint32_t _layoutVersion;
+    uint32_t _staticVersion;
+    uint32_t _activityVersion;
+};
+
+#endif // __BODY_STORE_H__
@@ -0,0 +1,50 @@
+#include "CollisionEventQueue.h"
+
+CollisionEventQueue::CollisionEventQueue() : _coalescing(true) {}
+
+void CollisionEventQueue::record(BodyStore::Handle a, BodyStore::Handle b, float impulse, const cocos2d::Vec3& normal, int substep,
+                                 bool heldA, bool heldB) {
+    if (_coalescing) {
+        uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+        uint32_t slot;
+        if (_pairSlots.find(key, slot)) {
+            CollisionEvent& e = _events[slot];
+            if (impulse > e.impulse) {
+                // Keep the pair's original orientation
+                bool same = e.a == a;
+                e.impulse = impulse;
+                e.normal = same ? normal : -normal;
+                e.heldA = same ? heldA : heldB;
+                e.heldB = same ? heldB : heldA;
+            }
+            return;
+        }
+        _pairSlots.set(key, (uint32_t)_events.size());
+    }
+
+    CollisionEvent e;
+    e.a = a;
+    e.b = b;
+    e.impulse = impulse;
+    e.normal = normal;
+    e.substep = substep;
+    e.heldA = heldA;
+    e.heldB = heldB;
+    _events.push_back(e);
+}
+
+void CollisionEventQueue::reserve(size_t count) {
+    _events.reserve(count);
+    _pairSlots.reserve(count);
+}
+
+void CollisionEventQueue::clear() {
+    _events.clear();
+    _pairSlots.clear();
+}
+
+void CollisionEventQueue::take(std::vector<CollisionEvent>& out) {
+    out.clear();
+    out.swap(_events);
+    _pairSlots.clear();
+}
@@ -0,0 +1,47 @@
+#ifndef __COLLISION_EVENT_QUEUE_H__
+#define __COLLISION_EVENT_QUEUE_H__
+
+#include "cocos2d.h"
+#include "BodyStore.h"
+#include "PairTable.h"
+#include <vector>
+
+// Contact recorded by the solver, dispatched to onCollision after the frame's
+// physics has run. Bodies are referenced by store handle, so an event whose
+// body was removed in the meantime can be dropped safely.
+struct CollisionEvent {
+    BodyStore::Handle a;
+    BodyStore::Handle b;
+    float impulse;              // Magnitude of the normal impulse
+    cocos2d::Vec3 normal;       // From a towards b
+    int substep;                // Substep of the frame the contact was resolved in
+    bool heldA;                 // Kinematic (held by its owner) when the contact was resolved;
+    bool heldB;                 // by dispatch time the owner may have let go, or picked it up
+};
+
+// Flat event buffer filled during the step. With coalescing on, repeated
+// contacts between the same pair within one frame collapse into a single
+// event carrying the strongest impulse (a rim rattle plays one sound).
+class CollisionEventQueue {
+public:
+    CollisionEventQueue();
+
+    void setCoalescing(bool enabled) { _coalescing = enabled; }
+    bool isCoalescing() const { return _coalescing; }
+
+    void record(BodyStore::Handle a, BodyStore::Handle b, float impulse, const cocos2d::Vec3& normal, int substep,
+                bool heldA, bool heldB);
+    void reserve(size_t count);
+    void clear();               // Keeps capacity
+    bool empty() const { return _events.empty(); }
+
+    // Moves the recorded events into 'out' (cleared first) and empties the queue
+    void take(std::vector<CollisionEvent>& out);
+
+private:
+    std::vector<CollisionEvent> _events;
+    PairTable _pairSlots;       // Pair key -> index in _events (coalescing only)
+    bool _coalescing;
+};
+
+#endif // __COLLISION_EVENT_QUEUE_H__
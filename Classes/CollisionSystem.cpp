@@ -1,11 +1,41 @@
 #include "CollisionSystem.h"
 #include "SimplePhysics.h"
 #include "PerformanceMonitor.h"
+#include "BodyIntegrator.h"
+#include "PhysicsAllocGuard.h"
+#include "WorkerPool.h"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 CollisionSystem* CollisionSystem::_instance = nullptr;
 
+// Grid covers the court plus a margin; bodies outside are clamped into the border cells
+const float CollisionSystem::GRID_CELL_SIZE = 2.0f;
+const int CollisionSystem::GRID_COLS = (int)std::ceil((SimplePhysics::COURT_WIDTH + 2.0f * GRID_CELL_SIZE) / GRID_CELL_SIZE);
+const int CollisionSystem::GRID_ROWS = (int)std::ceil((SimplePhysics::COURT_LENGTH + 2.0f * GRID_CELL_SIZE) / GRID_CELL_SIZE);
+
+// AABBs wider than this are not bucketed (e.g. the floor plane)
+static const float GRID_MAX_EXTENT = 50.0f;
+
+// Steps after a body is added / removed before the allocation guard arms
+// (buffers grow to their working size during this time)
+static const int ALLOC_GUARD_WARMUP_STEPS = 60;
+
+static void computeBodyAABB(const BodyStore& s, size_t i, cocos2d::AABB& box) {
+    if (s.flags[i] & BodyStore::FLAG_UNBOUNDED) {
+        // Very large box for planes
+        box._min.set(-1000, -100, -1000);
+        box._max.set(1000, 100, 1000);
+        return;
+    }
+    float ex = s.extentX[i];
+    float ey = s.extentY[i];
+    float ez = s.extentZ[i];
+    box._min.set(s.posX[i] - ex, s.posY[i] - ey, s.posZ[i] - ez);
+    box._max.set(s.posX[i] + ex, s.posY[i] + ey, s.posZ[i] + ez);
+}
+
 CollisionSystem* CollisionSystem::getInstance() {
     if (!_instance) {
         _instance = new CollisionSystem();
@@ -13,26 +43,81 @@ CollisionSystem* CollisionSystem::getInstance() {
     return _instance;
 }
 
-CollisionSystem::CollisionSystem() : _accumulator(0.0f) {}
+CollisionSystem::CollisionSystem()
+    : _accumulator(0.0f)
+    , _settledSteps(0)
+    , _frameSubstep(0)
+    , _workers(nullptr)
+    , _parallelThreshold(SimplePhysics::PARALLEL_NARROWPHASE_MIN_PAIRS)
+    , _solverStep(0)
+    , _broadPhaseType(BroadPhase::SWEEP_AND_PRUNE)
+    , _integrations(0)
+    , _partitionDirty(true)
+    , _partitionLayoutVersion(0)
+    , _partitionStaticVersion(0)
+    , _partitionActivityVersion(0)
+    , _sleepEnabled(true)
+    , _sapDirty(true)
+    , _sapLayoutVersion(0)
+    , _maxSpanZ(0.0f)
+    , _queryBoundsCurrent(false)
+    , _pairTests(0)
+{}
 
-CollisionSystem::~CollisionSystem() {}
+CollisionSystem::~CollisionSystem() {
+    // Detach so bodies outliving the world don't point into its store
+    reset();
+    if (_instance == this) _instance = nullptr;
+}
 
 void CollisionSystem::reset() {
-    _bodies.clear();
+    // Bodies keep their last state locally once detached
+    while (_store.size() > 0) {
+        _store.owner.back()->detach();
+    }
     _cachedPairs.clear();
+    _cachedPairKeys.clear();
+    _cachedPairIndex.clear();
+    _endpoints.clear();
+    _sapDirty = true;
+    _dynamicBodies.clear();
+    _staticUnbounded.clear();
+    _staticBVH.clear();
+    _awakeBodies.clear();
+    _awakeRuns.clear();
+    _partitionDirty = true;
+    _settledSteps = 0;
+    _events.clear();
+    _contactCache.clear();
+    _contactIndex.clear();
     _accumulator = 0.0f;
 }
 
+void CollisionSystem::setBroadPhase(BroadPhase type) {
+    if (_broadPhaseType == type) return;
+    _broadPhaseType = type;
+    _sapDirty = true;
+    _queryBoundsCurrent = false;
+}
+
+void CollisionSystem::setSleepEnabled(bool enabled) {
+    _sleepEnabled = enabled;
+    if (!enabled) {
+        for (size_t i = 0; i < _store.size(); ++i) {
+            _store.wake(i);
+        }
+    }
+}
+
 void CollisionSystem::addBody(RigidBody* body) {
-    if (std::find(_bodies.begin(), _bodies.end(), body) == _bodies.end()) {
-        _bodies.push_back(body);
+    if (body->getStore() != &_store) {
+        body->attach(&_store);
     }
 }
 
 void CollisionSystem::removeBody(RigidBody* body) {
-    auto it = std::find(_bodies.begin(), _bodies.end(), body);
-    if (it != _bodies.end()) {
-        _bodies.erase(it);
+    if (body->getStore() == &_store) {
+        body->detach();
     }
 }
 
@@ -43,16 +128,25 @@ void CollisionSystem::update(float dt) {
     if (_accumulator > 0.2f) _accumulator = 0.2f;
     
     int checks = 0;
+    _pairTests = 0;
+    _integrations = 0;
+    _frameSubstep = 0;
     while (_accumulator >= SimplePhysics::FIXED_TIME_STEP) {
         fixedUpdate(SimplePhysics::FIXED_TIME_STEP);
         _accumulator -= SimplePhysics::FIXED_TIME_STEP;
         checks++;
     }
     
+    // Game callbacks run once the world is consistent, outside the solver loop
+    dispatchEvents();
+    
+    syncNodes();
+    
     // Record Metrics
-    if (PerformanceMonitor::getInstance()->isDebugVisible()) {
-        PerformanceMonitor::getInstance()->recordCollisionChecks(_bodies.size() * _bodies.size() * checks); // Approximate
-        PerformanceMonitor::getInstance()->recordEntityCount(_bodies.size());
+    if (this == _instance && PerformanceMonitor::getInstance()->isDebugVisible()) {
+        PerformanceMonitor::getInstance()->recordCollisionChecks(_pairTests);
+        PerformanceMonitor::getInstance()->recordEntityCount((int)_store.size());
+        PerformanceMonitor::getInstance()->recordIntegrations(_integrations);
     }
 }
 
@@ -60,156 +154,1295 @@ float CollisionSystem::getAlpha() const {
     return _accumulator / SimplePhysics::FIXED_TIME_STEP;
 }
 
+void CollisionSystem::syncNodes() {
+    // One pass over the bodies in store order. Nodes are only touched when
+    // their interpolated position changed, so resting and sleeping bodies
+    // don't invalidate the scene graph.
+    BodyStore& s = _store;
+    float alpha = getAlpha();
+    float beta = 1.0f - alpha;
+    for (size_t i = 0, n = s.size(); i < n; ++i) {
+        cocos2d::Node* node = s.node[i];
+        if (!node || (s.flags[i] & BodyStore::FLAG_KINEMATIC)) continue;
+        
+        float x = s.prevX[i] * beta + s.posX[i] * alpha;
+        float y = s.prevY[i] * beta + s.posY[i] * alpha;
+        float z = s.prevZ[i] * beta + s.posZ[i] * alpha;
+        if (x == s.nodeX[i] && y == s.nodeY[i] && z == s.nodeZ[i]) continue;
+        
+        s.nodeX[i] = x;
+        s.nodeY[i] = y;
+        s.nodeZ[i] = z;
+        // Non-virtual: Player / Basketball override setPosition3D to move the body too
+        node->cocos2d::Node::setPosition3D(cocos2d::Vec3(x, y, z));
+    }
+}
+
+// Snapshot layout: header, then each section back to back
+static const size_t SNAPSHOT_FLOAT_ARRAYS = 13; // Position, previous position, velocity, force, sleep timer
+
+struct CollisionSystem::SnapshotHeader {
+    uint32_t bodyCount;
+    uint32_t layoutVersion;
+    uint32_t contactCount;
+    uint32_t endpointCount;
+    uint32_t cachedPairCount;
+    uint32_t solverStep;
+    float accumulator;
+    uint8_t sapValid;
+};
+
+template <typename T>
+static void writeSection(unsigned char*& out, const T* data, size_t count) {
+    memcpy(out, data, count * sizeof(T));
+    out += count * sizeof(T);
+}
+
+template <typename T>
+static void readSection(const unsigned char*& in, T* data, size_t count) {
+    memcpy(data, in, count * sizeof(T));
+    in += count * sizeof(T);
+}
+
+size_t CollisionSystem::snapshotSize(const SnapshotHeader& header) {
+    return sizeof(SnapshotHeader)
+        + header.contactCount * sizeof(CachedContact)
+        + header.endpointCount * sizeof(Endpoint)
+        + header.cachedPairCount * sizeof(uint64_t)
+        + header.bodyCount * (SNAPSHOT_FLOAT_ARRAYS * sizeof(float) + sizeof(uint8_t));
+}
+
+void CollisionSystem::snapshot(Snapshot& out) const {
+    const BodyStore& s = _store;
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.bodyCount = (uint32_t)s.size();
+    header.layoutVersion = s.getLayoutVersion();
+    header.contactCount = (uint32_t)_contactCache.size();
+    header.endpointCount = (uint32_t)_endpoints.size();
+    header.cachedPairCount = (uint32_t)_cachedPairKeys.size();
+    header.solverStep = _solverStep;
+    header.accumulator = _accumulator;
+    header.sapValid = !_sapDirty && _sapLayoutVersion == s.getLayoutVersion();
+    
+    size_t n = s.size();
+    out._data.resize(snapshotSize(header));
+    
+    unsigned char* p = out._data.data();
+    writeSection(p, &header, 1);
+    writeSection(p, _contactCache.data(), _contactCache.size());
+    writeSection(p, _endpoints.data(), _endpoints.size());
+    writeSection(p, _cachedPairKeys.data(), _cachedPairKeys.size());
+    writeSection(p, s.posX.data(), n); writeSection(p, s.posY.data(), n); writeSection(p, s.posZ.data(), n);
+    writeSection(p, s.prevX.data(), n); writeSection(p, s.prevY.data(), n); writeSection(p, s.prevZ.data(), n);
+    writeSection(p, s.velX.data(), n); writeSection(p, s.velY.data(), n); writeSection(p, s.velZ.data(), n);
+    writeSection(p, s.forceX.data(), n); writeSection(p, s.forceY.data(), n); writeSection(p, s.forceZ.data(), n);
+    writeSection(p, s.sleepTimer.data(), n);
+    writeSection(p, s.flags.data(), n);
+}
+
+bool CollisionSystem::restore(const Snapshot& snapshot) {
+    BodyStore& s = _store;
+    if (snapshot._data.size() < sizeof(SnapshotHeader)) return false;
+    
+    const unsigned char* p = snapshot._data.data();
+    SnapshotHeader header;
+    readSection(p, &header, 1);
+    if (header.bodyCount != s.size() || header.layoutVersion != s.getLayoutVersion()) return false;
+    if (snapshot._data.size() != snapshotSize(header)) return false;
+    
+    _accumulator = header.accumulator;
+    _solverStep = header.solverStep;
+    
+    _contactCache.resize(header.contactCount);
+    readSection(p, _contactCache.data(), _contactCache.size());
+    _contactIndex.clear();
+    for (size_t k = 0; k < _contactCache.size(); ++k) {
+        _contactIndex.set(_contactCache[k].key, (uint32_t)k);
+    }
+    
+    // Broadphase order decides the contact order, so it is part of the state
+    _endpoints.resize(header.endpointCount);
+    readSection(p, _endpoints.data(), _endpoints.size());
+    _cachedPairKeys.resize(header.cachedPairCount);
+    readSection(p, _cachedPairKeys.data(), _cachedPairKeys.size());
+    _cachedPairs.clear();
+    _cachedPairIndex.clear();
+    for (size_t k = 0; k < _cachedPairKeys.size(); ++k) {
+        uint64_t key = _cachedPairKeys[k];
+        _cachedPairs.push_back({s.owner[key >> 32], s.owner[key & 0xffffffffu]});
+        _cachedPairIndex.set(key, (uint32_t)k);
+    }
+    _sapDirty = !header.sapValid;
+    
+    size_t n = s.size();
+    
+    // A static moved since the snapshot needs the static BVH rebuilt
+    for (size_t i = 0; i < n; ++i) {
+        if (!(s.flags[i] & BodyStore::FLAG_STATIC)) continue;
+        float x, y, z;
+        memcpy(&x, p + i * sizeof(float), sizeof(float));
+        memcpy(&y, p + (n + i) * sizeof(float), sizeof(float));
+        memcpy(&z, p + (2 * n + i) * sizeof(float), sizeof(float));
+        if (x != s.posX[i] || y != s.posY[i] || z != s.posZ[i]) {
+            s.markStaticChanged();
+            break;
+        }
+    }
+    
+    readSection(p, s.posX.data(), n); readSection(p, s.posY.data(), n); readSection(p, s.posZ.data(), n);
+    readSection(p, s.prevX.data(), n); readSection(p, s.prevY.data(), n); readSection(p, s.prevZ.data(), n);
+    readSection(p, s.velX.data(), n); readSection(p, s.velY.data(), n); readSection(p, s.velZ.data(), n);
+    readSection(p, s.forceX.data(), n); readSection(p, s.forceY.data(), n); readSection(p, s.forceZ.data(), n);
+    readSection(p, s.sleepTimer.data(), n);
+    
+    // Only the sleep bit is state; the rest of the flags follow the bodies' setup
+    const uint8_t* flags = p;
+    bool activityChanged = false;
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t sleeping = flags[i] & BodyStore::FLAG_SLEEPING;
+        if ((s.flags[i] & BodyStore::FLAG_SLEEPING) != sleeping) {
+            s.flags[i] = (s.flags[i] & ~BodyStore::FLAG_SLEEPING) | sleeping;
+            activityChanged = true;
+        }
+    }
+    if (activityChanged) s.markActivityChanged();
+    
+    _events.clear();
+    _queryBoundsCurrent = false;
+    return true;
+}
+
+void CollisionSystem::hashState(StateHash& hash) const {
+    // What snapshot() captures, field by field (the structs have padding)
+    const BodyStore& s = _store;
+    size_t n = s.size();
+    hash.addBits((uint32_t)n);
+    hash.addFloat(_accumulator);
+    hash.addBits(_solverStep);
+    for (size_t i = 0; i < n; ++i) {
+        hash.addFloat(s.posX[i]); hash.addFloat(s.posY[i]); hash.addFloat(s.posZ[i]);
+        hash.addFloat(s.prevX[i]); hash.addFloat(s.prevY[i]); hash.addFloat(s.prevZ[i]);
+        hash.addFloat(s.velX[i]); hash.addFloat(s.velY[i]); hash.addFloat(s.velZ[i]);
+        hash.addFloat(s.forceX[i]); hash.addFloat(s.forceY[i]); hash.addFloat(s.forceZ[i]);
+        hash.addFloat(s.sleepTimer[i]);
+        hash.addBits(s.flags[i] & BodyStore::FLAG_SLEEPING);
+    }
+    for (const auto& c : _contactCache) {
+        hash.addU64(c.key);
+        hash.addBits(c.a);
+        hash.addVec3(c.normal);
+        hash.addFloat(c.normalImpulse);
+        hash.addVec3(c.tangentImpulse);
+        hash.addBits(c.step);
+    }
+    for (const auto& e : _endpoints) {
+        hash.addInt(e.proxy);
+        hash.addBool(e.isMin);
+    }
+    for (uint64_t key : _cachedPairKeys) {
+        hash.addU64(key);
+    }
+}
+
 void CollisionSystem::fixedUpdate(float dt) {
     // Sub-stepping for stability
     float subDt = dt / SimplePhysics::SUB_STEPS;
     
+    // Once the world has settled, the step must not allocate
+    if (!isPartitionCurrent()) _settledSteps = 0;
+    PhysicsAllocGuard::Scope allocGuard(PHYSICS_ALLOC_GUARD && _settledSteps >= ALLOC_GUARD_WARMUP_STEPS);
+    _settledSteps++;
+    
     for (int step = 0; step < SimplePhysics::SUB_STEPS; ++step) {
-        applyForces(subDt);
+        // Pick up bodies added, removed, put to sleep or woken since the last substep
+        updatePartition();
         
-        // Update positions
-        for (auto body : _bodies) {
-            body->update(subDt);
-        }
+        // Bodies about to reach a static collider get their own, finer
+        // steps against the statics; everything else takes one step.
+        // Both end at the same time, so the world is consistent afterwards.
+        planSubsteps(subDt);
+        integrate(subDt);
+        runSubsteps(subDt);
         
         enforceBoundaries();
         
-        std::vector<std::pair<RigidBody*, RigidBody*>> pairs;
-        broadPhase(pairs);
+        computeAABBs();
+        sweepFastBodies();
+        
+        _pairs.clear();
+        broadPhase(_pairs);
+        
+        _manifolds.clear();
+        narrowPhase(_pairs, _manifolds);
         
-        std::vector<Manifold> manifolds;
-        narrowPhase(pairs, manifolds);
+        wakeContacts(_manifolds);
+        resolveCollisions(_manifolds);
+        _frameSubstep++;
+    }
+    
+    pruneContactCache();
+    
+    if (_sleepEnabled) {
+        updateSleeping(_manifolds, dt);
+    }
+    
+    refreshBroadPhase();
+}
+
+void CollisionSystem::integrate(float dt) {
+    // Symplectic Euler with gravity applied as an acceleration, plus the
+    // hardcoded court floor (ball bounce / player clamp), batched over the
+    // contiguous runs of awake bodies
+    for (const auto& run : _stepRuns) {
+        BodyIntegrator::integrate(_store, dt, run.first, run.second);
+        _integrations += run.second - run.first;
+    }
+    
+    // Gravity is the only acceleration on a ballistic body, so the parabola
+    // is exact: no error builds up over the flight, however long
+    BodyStore& s = _store;
+    const float drop = 0.5f * SimplePhysics::GRAVITY * dt * dt;
+    for (int i : _ballistic) {
+        s.prevX[i] = s.posX[i];
+        s.prevY[i] = s.posY[i];
+        s.prevZ[i] = s.posZ[i];
+        s.posX[i] += s.velX[i] * dt;
+        s.posY[i] += s.velY[i] * dt + drop;
+        s.posZ[i] += s.velZ[i] * dt;
+        s.velY[i] += SimplePhysics::GRAVITY * dt;
+    }
+}
+
+bool CollisionSystem::isBallistic(int i, const cocos2d::AABB& reach, float dt) const {
+    // Only free projectiles: the ball, with nothing but gravity acting on it
+    const BodyStore& s = _store;
+    if (!(s.flags[i] & BodyStore::FLAG_CCD)) return false;
+    if (s.forceX[i] != 0.0f || s.forceY[i] != 0.0f || s.forceZ[i] != 0.0f) return false;
+    
+    // Stays above the floor and inside the court for the whole step
+    const float halfWidth = SimplePhysics::COURT_WIDTH / 2.0f;
+    const float halfLength = SimplePhysics::COURT_LENGTH / 2.0f;
+    if (reach._min.y + s.extentY[i] <= s.floorLevel[i]) return false;
+    if (reach._min.x < -halfWidth || reach._max.x > halfWidth) return false;
+    if (reach._min.z < -halfLength || reach._max.z > halfLength) return false;
+    
+    RigidBody* body = s.owner[i];
+    cocos2d::Vec3 center = (reach._min + reach._max) * 0.5f;
+    cocos2d::Vec3 extent = (reach._max - reach._min) * 0.5f;
+    for (int u : _staticUnbounded) {
+        RigidBody* plane = s.owner[u];
+        if (!canCollide(body, plane)) continue;
+        const cocos2d::Vec3& n = plane->getNormal();
+        float gap = n.dot(center) + plane->getPlaneConstant()
+            - (std::abs(n.x) * extent.x + std::abs(n.y) * extent.y + std::abs(n.z) * extent.z);
+        if (gap <= SimplePhysics::CONTACT_SLOP) return false;
+    }
+    
+    // Players (and other balls) where they could get to this step
+    cocos2d::AABB box;
+    for (int j : _dynamicBodies) {
+        if (j == i || !canCollide(body, s.owner[j])) continue;
+        computeBodyAABB(s, j, box);
+        float motion = std::sqrt(s.velX[j] * s.velX[j] + s.velY[j] * s.velY[j] + s.velZ[j] * s.velZ[j]) * dt;
+        cocos2d::Vec3 grow(motion, motion, motion);
+        box._min -= grow;
+        box._max += grow;
+        if (box.intersects(reach)) return false;
+    }
+    return true;
+}
+
+void CollisionSystem::planSubsteps(float dt) {
+    BodyStore& s = _store;
+    
+    for (int i : _substepped) _substepCount[i] = 0;
+    _substepCount.resize(s.size(), 0);
+    _substepped.clear();
+    for (int i : _ballistic) _isBallistic[i] = 0;
+    _isBallistic.resize(s.size(), 0);
+    _ballistic.clear();
+    
+    for (int i : _awakeBodies) {
+        if (s.flags[i] & BodyStore::FLAG_KINEMATIC) continue;
+        
+        // Where the body could get to this step
+        float speed = std::sqrt(s.velX[i] * s.velX[i] + s.velY[i] * s.velY[i] + s.velZ[i] * s.velZ[i]);
+        float motion = speed * dt;
+        float r = s.radius[i];
+        if (motion <= 0.0f) continue;
         
-        resolveCollisions(manifolds);
+        cocos2d::AABB reach;
+        computeBodyAABB(s, i, reach);
+        cocos2d::Vec3 grow(motion, motion, motion);
+        reach._min -= grow;
+        reach._max += grow;
+        
+        _staticHits.clear();
+        _staticBVH.query(reach, _staticHits);
+        if (_staticHits.empty()) {
+            // Nothing static in reach. If nothing else is either, a free
+            // flying ball skips the step and its collision passes entirely.
+            const float sag = -0.5f * SimplePhysics::GRAVITY * dt * dt + SimplePhysics::CONTACT_SLOP;
+            cocos2d::Vec3 margin(sag, sag, sag);
+            reach._min -= margin;
+            reach._max += margin;
+            if (isBallistic(i, reach, dt)) {
+                _isBallistic[i] = 1;
+                _ballistic.push_back(i);
+            }
+            continue;
+        }
+        
+        // Step size follows the thinnest collider in reach
+        float size = r;
+        for (int j : _staticHits) {
+            if (!canCollide(s.owner[i], s.owner[j])) continue;
+            size = std::min(size, s.radius[j]);
+        }
+        int steps = (int)std::ceil(motion / size);
+        steps = std::max(1, std::min(SimplePhysics::MAX_BODY_SUBSTEPS, steps));
+        if (steps < 2) continue;
+        
+        _substepCount[i] = (uint8_t)steps;
+        _substepped.push_back(i);
     }
+    
+    // Everything else is integrated in one go, over contiguous runs
+    if (_substepped.empty() && _ballistic.empty()) {
+        _stepRuns = _awakeRuns;
+        return;
+    }
+    _stepRuns.clear();
+    for (const auto& run : _awakeRuns) {
+        int begin = run.first;
+        for (int i = run.first; i < run.second; ++i) {
+            if (_substepCount[i] == 0 && !_isBallistic[i]) continue;
+            if (i > begin) _stepRuns.push_back(std::make_pair(begin, i));
+            begin = i + 1;
+        }
+        if (run.second > begin) _stepRuns.push_back(std::make_pair(begin, run.second));
+    }
+}
+
+void CollisionSystem::runSubsteps(float dt) {
+    BodyStore& s = _store;
+    if (_substepped.empty()) return;
+    
+    // The sweeps test the other dynamic bodies' boxes: move them to where
+    // integrate() just put everything, not where the last step's broadphase saw it
+    computeAABBs();
+    
+    for (int i : _substepped) {
+        int steps = _substepCount[i];
+        float stepDt = dt / steps;
+        cocos2d::Vec3 start(s.posX[i], s.posY[i], s.posZ[i]);
+        
+        for (int k = 0; k < steps; ++k) {
+            BodyIntegrator::integrate(s, stepDt, i, i + 1);
+            enforceBoundary(i);
+            if (isFastBody(i)) sweepBody(i);
+            collideWithStatics(i);
+        }
+        _integrations += steps;
+        computeBodyAABB(s, i, _aabbs[i]); // The last substep's contacts moved it
+        
+        // Interpolate over the whole step, like every other body
+        s.prevX[i] = start.x;
+        s.prevY[i] = start.y;
+        s.prevZ[i] = start.z;
+    }
+}
+
+void CollisionSystem::collideWithStatics(int i) {
+    computeBodyAABB(_store, i, _aabbs[i]);
+    RigidBody* body = _store.owner[i];
+    
+    _staticHits.clear();
+    for (int u : _staticUnbounded) _staticHits.push_back(u);
+    _pairTests += _staticBVH.query(_aabbs[i], _staticHits);
+    
+    // Same pair order as the broadphase (ascending dense index)
+    std::sort(_staticHits.begin(), _staticHits.end());
+    _staticPairs.clear();
+    for (int j : _staticHits) {
+        RigidBody* other = _store.owner[j];
+        if (!canCollide(body, other)) continue;
+        _staticPairs.push_back(i < j ? std::make_pair(body, other) : std::make_pair(other, body));
+    }
+    
+    _staticManifolds.clear();
+    narrowPhase(_staticPairs, _staticManifolds);
+    resolveCollisions(_staticManifolds);
 }
 
 void CollisionSystem::enforceBoundaries() {
-    float halfWidth = SimplePhysics::COURT_WIDTH / 2.0f;
-    float halfLength = SimplePhysics::COURT_LENGTH / 2.0f;
+    for (int i : _awakeBodies) {
+        enforceBoundary(i);
+    }
+}
+
+void CollisionSystem::enforceBoundary(int i) {
+    BodyStore& s = _store;
+    const float halfWidth = SimplePhysics::COURT_WIDTH / 2.0f;
+    const float halfLength = SimplePhysics::COURT_LENGTH / 2.0f;
+
+    float radius = s.radius[i];
+    float restitution = s.restitution[i];
+
+    // Check X (Width)
+    if (s.posX[i] < -halfWidth + radius) {
+        s.posX[i] = -halfWidth + radius;
+        if (s.velX[i] < 0) s.velX[i] *= -restitution;
+    } else if (s.posX[i] > halfWidth - radius) {
+        s.posX[i] = halfWidth - radius;
+        if (s.velX[i] > 0) s.velX[i] *= -restitution;
+    }
+
+    // Check Z (Length)
+    if (s.posZ[i] < -halfLength + radius) {
+        s.posZ[i] = -halfLength + radius;
+        if (s.velZ[i] < 0) s.velZ[i] *= -restitution;
+    } else if (s.posZ[i] > halfLength - radius) {
+        s.posZ[i] = halfLength - radius;
+        if (s.velZ[i] > 0) s.velZ[i] *= -restitution;
+    }
+}
+
+void CollisionSystem::refreshBroadPhase() {
+    // The solver moved bodies after the last broadphase pass. Put the boxes
+    // and the broadphase back in line with the positions, so scene queries
+    // between steps can go through the broadphase.
+    _maxSpanZ = 0.0f;
+    for (int i : _dynamicBodies) {
+        computeBodyAABB(_store, i, _aabbs[i]);
+        _maxSpanZ = std::max(_maxSpanZ, _aabbs[i]._max.z - _aabbs[i]._min.z);
+    }
+    if (_broadPhaseType == BroadPhase::GRID) {
+        buildGrid();
+    } else {
+        updateEndpoints();
+    }
+    _queryBoundsCurrent = true;
+}
+
+void CollisionSystem::computeAABBs() {
+    // Static boxes are computed once, and sleeping bodies keep theirs
+    for (int i : _awakeBodies) {
+        computeBodyAABB(_store, i, _aabbs[i]);
+    }
+}
+
+bool CollisionSystem::isPartitionCurrent() const {
+    return !_partitionDirty &&
+        _partitionLayoutVersion == _store.getLayoutVersion() &&
+        _partitionStaticVersion == _store.getStaticVersion();
+}
+
+void CollisionSystem::updatePartition() {
+    if (isPartitionCurrent()) {
+        if (_partitionActivityVersion != _store.getActivityVersion()) {
+            updateActivity();
+        }
+        return;
+    }
+    
+    const size_t count = _store.size();
+    _aabbs.resize(count);
+    _dynamicBodies.clear();
+    _staticUnbounded.clear();
+    
+    _staticBoxes.clear();
+    _staticIds.clear();
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t flags = _store.flags[i];
+        computeBodyAABB(_store, i, _aabbs[i]);
+        if (!(flags & BodyStore::FLAG_STATIC)) {
+            _dynamicBodies.push_back((int)i);
+            continue;
+        }
+        // Statics never integrate; keep interpolation on their actual position
+        _store.prevX[i] = _store.posX[i];
+        _store.prevY[i] = _store.posY[i];
+        _store.prevZ[i] = _store.posZ[i];
+        if (flags & BodyStore::FLAG_UNBOUNDED) {
+            _staticUnbounded.push_back((int)i);
+        } else {
+            _staticBoxes.push_back(_aabbs[i]);
+            _staticIds.push_back((int)i);
+        }
+    }
+    _staticBVH.build(_staticBoxes, _staticIds);
+    
+    // Give the per-step buffers room for a typical number of contacts
+    size_t expectedPairs = count * 4 + 64;
+    _pairs.reserve(expectedPairs);
+    _sortedPairs.reserve(expectedPairs);
+    _manifolds.reserve(expectedPairs);
+    _candidates.reserve(expectedPairs);
+    _cachedPairs.reserve(expectedPairs);
+    _cachedPairKeys.reserve(expectedPairs);
+    _cachedPairIndex.reserve(expectedPairs);
+    _events.reserve(expectedPairs);
+    _dispatching.reserve(expectedPairs);
+    _contacts.reserve(expectedPairs);
+    _contactCache.reserve(expectedPairs);
+    _contactIndex.reserve(expectedPairs);
+    
+    // Worker threads are started here rather than mid-step. The pool is
+    // shared, so only the default world uses it.
+    if (!_workers && this == _instance) _workers = WorkerPool::getInstance();
+    _workerManifolds.resize(_workers ? _workers->getWorkerCount() : 0);
+    for (auto& out : _workerManifolds) out.reserve(expectedPairs);
+    
+    // Lists bounded by the body count
+    size_t staticCount = _staticIds.size() + _staticUnbounded.size();
+    _staticHits.reserve(staticCount);
+    _staticPairs.reserve(staticCount);
+    _staticManifolds.reserve(staticCount);
+    _awakeBodies.reserve(count);
+    _awakeRuns.reserve(count);
+    _stepRuns.reserve(count);
+    _fastBodies.reserve(count);
+    _queryBodies.reserve(count);
+    _queryBoxes.reserve(count);
+    _substepped.reserve(count);
+    _substepCount.reserve(count);
+    _ballistic.reserve(count);
+    _isBallistic.reserve(count);
+    _islandParent.reserve(count);
+    _islandTimer.reserve(count);
+    _cellRanges.reserve(count);
+    _unbounded.reserve(count);
+    
+    _partitionDirty = false;
+    _partitionLayoutVersion = _store.getLayoutVersion();
+    _partitionStaticVersion = _store.getStaticVersion();
+    _sapDirty = true;
+    _queryBoundsCurrent = false;
+    updateActivity();
+}
+
+void CollisionSystem::updateActivity() {
+    _awakeBodies.clear();
+    _awakeRuns.clear();
+    for (int i : _dynamicBodies) {
+        if (_store.isSleeping(i)) continue;
+        
+        if (!_awakeRuns.empty() && _awakeRuns.back().second == i) {
+            _awakeRuns.back().second = i + 1;
+        } else {
+            _awakeRuns.push_back(std::make_pair(i, i + 1));
+        }
+        _awakeBodies.push_back(i);
+    }
+    _partitionActivityVersion = _store.getActivityVersion();
+}
+
+bool CollisionSystem::bothAsleep(int i, int j) const {
+    return (_store.flags[i] & _store.flags[j] & BodyStore::FLAG_SLEEPING) != 0;
+}
+
+void CollisionSystem::wakeContacts(const std::vector<Manifold>& manifolds) {
+    // Anything touched by an awake body wakes up before the impulse is applied
+    for (const auto& m : manifolds) {
+        if (m.a->isSleeping()) m.a->wakeUp();
+        if (m.b->isSleeping()) m.b->wakeUp();
+    }
+}
+
+int CollisionSystem::findIsland(int i) {
+    while (_islandParent[i] != i) {
+        _islandParent[i] = _islandParent[_islandParent[i]];
+        i = _islandParent[i];
+    }
+    return i;
+}
+
+void CollisionSystem::updateSleeping(const std::vector<Manifold>& manifolds, float dt) {
+    BodyStore& s = _store;
+    updatePartition();
+    
+    const float threshold = SimplePhysics::SLEEP_LINEAR_VELOCITY * SimplePhysics::SLEEP_LINEAR_VELOCITY;
+    _islandParent.resize(s.size());
+    _islandTimer.resize(s.size());
+    
+    for (int i : _awakeBodies) {
+        _islandParent[i] = i;
+        
+        // Kinematic bodies are driven by gameplay code and never sleep
+        if (s.flags[i] & BodyStore::FLAG_KINEMATIC) {
+            s.sleepTimer[i] = 0.0f;
+            continue;
+        }
+        float speed = s.velX[i] * s.velX[i] + s.velY[i] * s.velY[i] + s.velZ[i] * s.velZ[i];
+        s.sleepTimer[i] = speed < threshold ? s.sleepTimer[i] + dt : 0.0f;
+    }
+    
+    // Dynamic bodies in contact share an island (statics and kinematics don't link islands)
+    const uint8_t noLink = BodyStore::FLAG_STATIC | BodyStore::FLAG_KINEMATIC;
+    for (const auto& m : manifolds) {
+        int a = (int)s.indexOf(m.a->getHandle());
+        int b = (int)s.indexOf(m.b->getHandle());
+        if ((s.flags[a] | s.flags[b]) & noLink) continue;
+        
+        int ra = findIsland(a);
+        int rb = findIsland(b);
+        if (ra != rb) _islandParent[ra] = rb;
+    }
+    
+    // An island sleeps only once every body in it has been resting long enough
+    for (int i : _awakeBodies) {
+        _islandTimer[i] = SimplePhysics::SLEEP_TIME;
+    }
+    for (int i : _awakeBodies) {
+        int root = findIsland(i);
+        _islandTimer[root] = std::min(_islandTimer[root], s.sleepTimer[i]);
+    }
+    for (int i : _awakeBodies) {
+        if (s.flags[i] & BodyStore::FLAG_KINEMATIC) continue;
+        if (_islandTimer[findIsland(i)] >= SimplePhysics::SLEEP_TIME) {
+            s.sleep(i);
+        }
+    }
+}
+
+// Time of impact of a sphere moving from 'start' by 'motion' against a sphere
+// of combined radius 'radius' at 'center'. Only reports entering hits in [0, 1].
+static bool sweepSphere(const cocos2d::Vec3& start, const cocos2d::Vec3& motion,
+                        const cocos2d::Vec3& center, float radius, float& t) {
+    cocos2d::Vec3 m = start - center;
+    float c = m.dot(m) - radius * radius;
+    if (c <= 0.0f) return false; // Already touching: the narrowphase handles it
+    float b = m.dot(motion);
+    if (b >= 0.0f) return false; // Moving away
+    float a = motion.dot(motion);
+    float disc = b * b - a * c;
+    if (disc < 0.0f) return false;
+    t = (-b - std::sqrt(disc)) / a;
+    return t <= 1.0f;
+}
+
+// Same against a capsule (segment bottom..top inflated by 'radius')
+static bool sweepCapsule(const cocos2d::Vec3& start, const cocos2d::Vec3& motion,
+                         const cocos2d::Vec3& bottom, const cocos2d::Vec3& top, float radius, float& t) {
+    cocos2d::Vec3 axis = top - bottom;
+    cocos2d::Vec3 oa = start - bottom;
+    float axisSq = axis.dot(axis);
+    float axisMotion = axis.dot(motion);
+    float axisStart = axis.dot(oa);
+    float motionSq = motion.dot(motion);
+    
+    // Already touching at the start
+    float s = std::max(0.0f, std::min(1.0f, axisStart / axisSq));
+    if ((oa - axis * s).lengthSquared() <= radius * radius) return false;
+    
+    // Infinite cylinder around the axis
+    float a = axisSq * motionSq - axisMotion * axisMotion;
+    float b = axisSq * motion.dot(oa) - axisStart * axisMotion;
+    float c = axisSq * oa.dot(oa) - axisStart * axisStart - radius * radius * axisSq;
+    float h = b * b - a * c;
+    if (h < 0.0f) return false; // Misses the cylinder, so the caps too
+    
+    if (a > 0.000001f) {
+        t = (-b - std::sqrt(h)) / a;
+        float y = axisStart + t * axisMotion;
+        if (y > 0.0f && y < axisSq) {
+            return t >= 0.0f && t <= 1.0f;
+        }
+        // Outside the side wall: hit one of the end spheres instead
+        return sweepSphere(start, motion, y <= 0.0f ? bottom : top, radius, t);
+    }
+    
+    // Moving along the axis
+    return sweepSphere(start, motion, axisStart <= 0.0f ? bottom : top, radius, t);
+}
+
+// Same against the plane n.p + d = 0, for a sphere of 'radius'
+static bool sweepPlane(const cocos2d::Vec3& start, const cocos2d::Vec3& motion,
+                       const cocos2d::Vec3& normal, float constant, float radius, float& t) {
+    float d0 = normal.dot(start) + constant - radius;
+    float d1 = normal.dot(start + motion) + constant - radius;
+    if (d0 <= 0.0f || d1 >= 0.0f) return false;
+    t = d0 / (d0 - d1);
+    return true;
+}
 
-    for (auto body : _bodies) {
-        if (body->isStatic()) continue;
+// Time of impact against an oriented box grown by 'radius' (corners and edges
+// are treated as square, which is conservative). Slab test in box space.
+static bool sweepBox(const cocos2d::Vec3& start, const cocos2d::Vec3& motion,
+                     RigidBody* box, float radius, float& t) {
+    cocos2d::Vec3 d = start - box->getPosition();
+    const cocos2d::Vec3& h = box->getHalfExtents();
+    float half[3] = { h.x, h.y, h.z };
+    
+    float enter = 0.0f;
+    float exit = 1.0f;
+    bool outside = false;
+    for (int k = 0; k < 3; ++k) {
+        const cocos2d::Vec3& axis = box->getBoxAxis(k);
+        float p = d.dot(axis);
+        float v = motion.dot(axis);
+        float extent = half[k] + radius;
+        if (std::abs(p) > extent) outside = true;
+        
+        if (std::abs(v) < 1.0e-8f) {
+            if (std::abs(p) > extent) return false;
+            continue;
+        }
+        float t0 = (-extent - p) / v;
+        float t1 = (extent - p) / v;
+        if (t0 > t1) std::swap(t0, t1);
+        enter = std::max(enter, t0);
+        exit = std::min(exit, t1);
+        if (enter > exit) return false;
+    }
+    if (!outside) return false; // Already touching: the narrowphase handles it
+    t = enter;
+    return true;
+}
 
-        cocos2d::Vec3 pos = body->getPosition();
-        cocos2d::Vec3 vel = body->getVelocity();
-        float radius = body->getRadius();
+// Closest point on the torus' center circle to 'point'
+static cocos2d::Vec3 closestOnRing(RigidBody* torus, const cocos2d::Vec3& point) {
+    cocos2d::Vec3 center = torus->getPosition();
+    cocos2d::Vec3 planar(point.x - center.x, 0, point.z - center.z);
+    float len = planar.length();
+    if (len < 0.0001f) {
+        planar = cocos2d::Vec3::UNIT_X; // On the axis: every point of the circle is equally close
+    } else {
+        planar *= 1.0f / len;
+    }
+    return center + planar * torus->getRingRadius();
+}
 
-        bool modified = false;
+// Time of impact against a torus grown by 'radius'. The exact answer is a
+// quartic; conservative advancement gets there in a few steps because the
+// distance to the tube can never shrink faster than the body moves.
+static bool sweepTorus(const cocos2d::Vec3& start, const cocos2d::Vec3& motion,
+                       RigidBody* torus, float radius, float& t) {
+    float length = motion.length();
+    if (length < 1.0e-6f) return false;
+    float reach = torus->getRadius() + radius;
+    
+    float at = 0.0f;
+    for (int k = 0; k < 32; ++k) {
+        cocos2d::Vec3 p = start + motion * at;
+        float gap = p.distance(closestOnRing(torus, p)) - reach;
+        if (gap <= SimplePhysics::CCD_SKIN) {
+            if (k == 0) return false; // Already touching: the narrowphase handles it
+            t = at;
+            return true;
+        }
+        at += gap / length;
+        if (at > 1.0f) return false;
+    }
+    return false; // Grazing pass: still approaching after all steps
+}
 
-        // Check X (Width)
-        if (pos.x < -halfWidth + radius) {
-            pos.x = -halfWidth + radius;
-            if (vel.x < 0) vel.x *= -body->getMaterial().restitution;
-            modified = true;
-        } else if (pos.x > halfWidth - radius) {
-            pos.x = halfWidth - radius;
-            if (vel.x > 0) vel.x *= -body->getMaterial().restitution;
-            modified = true;
+// Time of impact of a sphere of 'radius' moving from 'start' by 'motion' against 'other'
+static bool sweepShape(RigidBody* other, const cocos2d::Vec3& start, const cocos2d::Vec3& motion,
+                       float radius, float& toi) {
+    cocos2d::Vec3 pos = other->getPosition();
+    
+    switch (other->getType()) {
+        case ColliderType::SPHERE:
+            return sweepSphere(start, motion, pos, radius + other->getRadius(), toi);
+        case ColliderType::CAPSULE: {
+            cocos2d::Vec3 half(0, other->getHeight() / 2, 0);
+            return sweepCapsule(start, motion, pos - half, pos + half, radius + other->getRadius(), toi);
         }
+        case ColliderType::PLANE:
+            return sweepPlane(start, motion, other->getNormal(), other->getPlaneConstant(), radius, toi);
+        case ColliderType::BOX:
+            return sweepBox(start, motion, other, radius, toi);
+        case ColliderType::TORUS:
+            return sweepTorus(start, motion, other, radius, toi);
+    }
+    return false;
+}
 
-        // Check Z (Length)
-        if (pos.z < -halfLength + radius) {
-            pos.z = -halfLength + radius;
-            if (vel.z < 0) vel.z *= -body->getMaterial().restitution;
-            modified = true;
-        } else if (pos.z > halfLength - radius) {
-            pos.z = halfLength - radius;
-            if (vel.z > 0) vel.z *= -body->getMaterial().restitution;
-            modified = true;
+bool CollisionSystem::sweepAgainst(int i, int target, const cocos2d::Vec3& start, const cocos2d::Vec3& motion, float& toi) {
+    RigidBody* body = _store.owner[i];
+    RigidBody* other = _store.owner[target];
+    if (!canCollide(body, other)) return false;
+    
+    _pairTests++;
+    // Shrink by the skin so the body ends up just inside contact
+    return sweepShape(other, start, motion, body->getRadius() - SimplePhysics::CCD_SKIN, toi);
+}
+
+bool CollisionSystem::isFastBody(int i) const {
+    const BodyStore& s = _store;
+    if (!(s.flags[i] & BodyStore::FLAG_CCD) || (s.flags[i] & BodyStore::FLAG_KINEMATIC)) return false;
+    
+    float dx = s.posX[i] - s.prevX[i];
+    float dy = s.posY[i] - s.prevY[i];
+    float dz = s.posZ[i] - s.prevZ[i];
+    float limit = s.radius[i] * SimplePhysics::CCD_MOTION_THRESHOLD;
+    return dx * dx + dy * dy + dz * dz > limit * limit;
+}
+
+void CollisionSystem::sweepFastBodies() {
+    // Substepped bodies were swept step by step already
+    _fastBodies.clear();
+    for (int i : _awakeBodies) {
+        if (_substepCount[i] == 0 && !_isBallistic[i] && isFastBody(i)) {
+            _fastBodies.push_back(i);
         }
+    }
+    
+    for (int i : _fastBodies) {
+        sweepBody(i);
+    }
+}
 
-        if (modified) {
-            body->setPosition(pos);
-            body->setVelocity(vel);
+void CollisionSystem::sweepBody(int i) {
+    // Sweep from the previous position and stop at the earliest impact.
+    // Other bodies are taken at their end-of-step positions.
+    BodyStore& s = _store;
+    
+    cocos2d::Vec3 start(s.prevX[i], s.prevY[i], s.prevZ[i]);
+    cocos2d::Vec3 end(s.posX[i], s.posY[i], s.posZ[i]);
+    cocos2d::Vec3 motion = end - start;
+    
+    float r = s.radius[i];
+    cocos2d::Vec3 extent(r, r, r);
+    cocos2d::AABB swept(start - extent, start + extent);
+    swept.merge(cocos2d::AABB(end - extent, end + extent));
+    
+    float best = 1.0f;
+    bool hit = false;
+    float toi;
+    
+    for (int u : _staticUnbounded) {
+        if (sweepAgainst(i, u, start, motion, toi) && toi < best) { best = toi; hit = true; }
+    }
+    
+    _staticHits.clear();
+    _pairTests += _staticBVH.query(swept, _staticHits);
+    for (int j : _staticHits) {
+        if (sweepAgainst(i, j, start, motion, toi) && toi < best) { best = toi; hit = true; }
+    }
+    
+    for (int j : _dynamicBodies) {
+        if (j == i || !_aabbs[j].intersects(swept)) continue;
+        if (sweepAgainst(i, j, start, motion, toi) && toi < best) { best = toi; hit = true; }
+    }
+    
+    if (hit) {
+        cocos2d::Vec3 p = start + motion * best;
+        s.posX[i] = p.x; s.posY[i] = p.y; s.posZ[i] = p.z;
+        computeBodyAABB(s, i, _aabbs[i]);
+    }
+}
+
+void CollisionSystem::queryStatics() {
+    // Sleeping bodies don't query: static contacts can't wake them.
+    // Substepped bodies already collided with the statics, and ballistic
+    // ones are clear of them.
+    for (int i : _awakeBodies) {
+        if (_substepCount[i] != 0 || _isBallistic[i]) continue;
+        RigidBody* body = _store.owner[i];
+        
+        for (int u : _staticUnbounded) {
+            if (testPair(i, u)) {
+                _candidates.push_back(i < u ? std::make_pair(i, u) : std::make_pair(u, i));
+            }
+        }
+        
+        _staticHits.clear();
+        _pairTests += _staticBVH.query(_aabbs[i], _staticHits);
+        for (int j : _staticHits) {
+            if (!canCollide(body, _store.owner[j])) continue;
+            _candidates.push_back(i < j ? std::make_pair(i, j) : std::make_pair(j, i));
         }
     }
 }
 
-void CollisionSystem::applyForces(float dt) {
-    for (auto body : _bodies) {
-        if (body->isStatic() || body->isKinematic()) continue;
+int CollisionSystem::cellX(float x) const {
+    int c = (int)std::floor((x + SimplePhysics::COURT_WIDTH / 2.0f) / GRID_CELL_SIZE) + 1;
+    return std::max(0, std::min(GRID_COLS - 1, c));
+}
+
+int CollisionSystem::cellZ(float z) const {
+    int c = (int)std::floor((z + SimplePhysics::COURT_LENGTH / 2.0f) / GRID_CELL_SIZE) + 1;
+    return std::max(0, std::min(GRID_ROWS - 1, c));
+}
+
+void CollisionSystem::buildGrid() {
+    _cellRanges.resize(_store.size());
+    _unbounded.clear();
+    
+    // 1. Count cell occupancy of the dynamic bodies
+    _cellStart.assign(GRID_COLS * GRID_ROWS + 1, 0);
+    for (int i : _dynamicBodies) {
+        const cocos2d::AABB& box = _aabbs[i];
+        
+        if (box._max.x - box._min.x > GRID_MAX_EXTENT || box._max.z - box._min.z > GRID_MAX_EXTENT) {
+            _unbounded.push_back(i);
+            _cellRanges[i] = {0, -1, 0, -1};
+            continue;
+        }
         
-        // Gravity
-        cocos2d::Vec3 gravity(0, SimplePhysics::GRAVITY, 0);
-        body->applyForce(gravity * body->getMass());
+        CellRange& r = _cellRanges[i];
+        r.x0 = cellX(box._min.x);
+        r.x1 = cellX(box._max.x);
+        r.z0 = cellZ(box._min.z);
+        r.z1 = cellZ(box._max.z);
         
-        // Air Resistance Removed for precise ballistic calculation
-        // if (body->getCategoryMask() & SimplePhysics::MASK_BALL) { ... }
+        for (int z = r.z0; z <= r.z1; ++z) {
+            for (int x = r.x0; x <= r.x1; ++x) {
+                _cellStart[z * GRID_COLS + x + 1]++;
+            }
+        }
+    }
+    
+    // 2. Prefix sum, then scatter body indices into their cells
+    for (size_t c = 1; c < _cellStart.size(); ++c) {
+        _cellStart[c] += _cellStart[c - 1];
+    }
+    _cellEntries.resize(_cellStart.back());
+    
+    _cellFill.assign(_cellStart.begin(), _cellStart.end() - 1);
+    for (int i : _dynamicBodies) {
+        const CellRange& r = _cellRanges[i];
+        for (int z = r.z0; z <= r.z1; ++z) {
+            for (int x = r.x0; x <= r.x1; ++x) {
+                _cellEntries[_cellFill[z * GRID_COLS + x]++] = i;
+            }
+        }
+    }
+}
+
+bool CollisionSystem::canCollide(RigidBody* a, RigidBody* b) const {
+    // Skip if both static
+    if (a->isStatic() && b->isStatic()) return false;
+    
+    // Players are kept on the court by the integrator's floor clamp (their
+    // origin is at the feet), so the floor plane stays out of their contacts
+    if (a->getType() == ColliderType::PLANE || b->getType() == ColliderType::PLANE) {
+        RigidBody* other = a->getType() == ColliderType::PLANE ? b : a;
+        if (_store.flags[_store.indexOf(other->getHandle())] & BodyStore::FLAG_FLOOR_CLAMP) return false;
     }
+    
+    // Filter masks
+    return (a->getCategoryMask() & b->getCollisionMask()) != 0 &&
+           (b->getCategoryMask() & a->getCollisionMask()) != 0;
+}
+
+bool CollisionSystem::testPair(int i, int j) {
+    if (bothAsleep(i, j)) return false;
+    if (!canCollide(_store.owner[i], _store.owner[j])) return false;
+    
+    _pairTests++;
+    return _aabbs[i].intersects(_aabbs[j]);
 }
 
 void CollisionSystem::broadPhase(std::vector<std::pair<RigidBody*, RigidBody*>>& pairs) {
-    // Optimization: Skip Static-Static collisions
-    // And Distance Check
+    _candidates.clear();
     
-    size_t count = _bodies.size();
-    for (size_t i = 0; i < count; ++i) {
-        for (size_t j = i + 1; j < count; ++j) {
-            RigidBody* a = _bodies[i];
-            RigidBody* b = _bodies[j];
-            
-            // Skip if both static
-            if (a->isStatic() && b->isStatic()) continue;
-            
-            // Filter masks
-            if ((a->getCategoryMask() & b->getCollisionMask()) == 0 ||
-                (b->getCategoryMask() & a->getCollisionMask()) == 0) continue;
-            
-            // AABB Check
-            if (a->getAABB().intersects(b->getAABB())) {
-                pairs.push_back({a, b});
+    // Dynamic vs dynamic
+    if (_broadPhaseType == BroadPhase::GRID) {
+        gridBroadPhase();
+    } else {
+        sweepAndPrune();
+    }
+    
+    // Dynamic vs static
+    queryStatics();
+    
+    // Keep the same pair order as the all-pairs loop so resolution order is unchanged
+    std::sort(_candidates.begin(), _candidates.end());
+    for (const auto& c : _candidates) {
+        pairs.push_back({_store.owner[c.first], _store.owner[c.second]});
+    }
+}
+
+void CollisionSystem::gridBroadPhase() {
+    // Uniform grid over the dynamic bodies: only bodies sharing a cell are tested.
+    // A pair spanning several shared cells is reported once, from the
+    // lowest shared cell (max of both range minimums).
+    buildGrid();
+    
+    // Entries within a cell are in ascending body order, so walking each
+    // body's cells and only looking at later entries visits every pair once per shared cell.
+    for (int i : _dynamicBodies) {
+        const CellRange& ri = _cellRanges[i];
+        for (int z = ri.z0; z <= ri.z1; ++z) {
+            for (int x = ri.x0; x <= ri.x1; ++x) {
+                int cell = z * GRID_COLS + x;
+                int end = _cellStart[cell + 1];
+                for (int p = _cellStart[cell]; p < end; ++p) {
+                    int j = _cellEntries[p];
+                    if (j <= i) continue;
+                    const CellRange& rj = _cellRanges[j];
+                    if (std::max(ri.x0, rj.x0) != x || std::max(ri.z0, rj.z0) != z) continue;
+                    
+                    if (testPair(i, j)) {
+                        _candidates.push_back(std::make_pair(i, j));
+                    }
+                }
             }
         }
     }
+    
+    // Unbounded dynamic bodies are tested against every other dynamic body
+    for (size_t u = 0; u < _unbounded.size(); ++u) {
+        int i = _unbounded[u];
+        for (int j : _dynamicBodies) {
+            if (j == i) continue;
+            // Unbounded-unbounded pairs are visited twice; keep the first
+            if (_cellRanges[j].x1 < _cellRanges[j].x0 && j < i) continue;
+            if (testPair(i, j)) {
+                _candidates.push_back(i < j ? std::make_pair(i, j) : std::make_pair(j, i));
+            }
+        }
+    }
+}
+
+static inline uint64_t pairKey(int a, int b) {
+    if (a > b) std::swap(a, b);
+    return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+}
+
+// Ties sort min before max so touching intervals count as overlapping (matches AABB::intersects)
+static inline bool endpointLess(const float value, bool isMin, const float otherValue, bool otherIsMin) {
+    return value < otherValue || (value == otherValue && isMin && !otherIsMin);
+}
+
+void CollisionSystem::addCachedPair(int a, int b) {
+    if (!canCollide(_store.owner[a], _store.owner[b])) return;
+    
+    uint64_t key = pairKey(a, b);
+    if (_cachedPairIndex.contains(key)) return;
+    
+    _cachedPairIndex.set(key, (uint32_t)_cachedPairs.size());
+    _cachedPairs.push_back({_store.owner[a], _store.owner[b]});
+    _cachedPairKeys.push_back(key);
+}
+
+void CollisionSystem::removeCachedPair(int a, int b) {
+    uint64_t key = pairKey(a, b);
+    uint32_t slot;
+    if (!_cachedPairIndex.find(key, slot)) return;
+    
+    // Swap-remove, fixing up the index of the moved entry
+    size_t last = _cachedPairs.size() - 1;
+    if (slot != last) {
+        _cachedPairs[slot] = _cachedPairs[last];
+        _cachedPairKeys[slot] = _cachedPairKeys[last];
+        _cachedPairIndex.set(_cachedPairKeys[slot], slot);
+    }
+    _cachedPairs.pop_back();
+    _cachedPairKeys.pop_back();
+    _cachedPairIndex.erase(key);
+}
+
+void CollisionSystem::rebuildEndpoints() {
+    // Full rebuild, only when bodies are added or removed (or the static set changes)
+    _cachedPairs.clear();
+    _cachedPairKeys.clear();
+    _cachedPairIndex.clear();
+    _endpoints.clear();
+    
+    for (int i : _dynamicBodies) {
+        const cocos2d::AABB& box = _aabbs[i];
+        _endpoints.push_back({box._min.z, i, true});
+        _endpoints.push_back({box._max.z, i, false});
+    }
+    // Ties go by proxy so the order doesn't depend on the sort implementation
+    std::sort(_endpoints.begin(), _endpoints.end(), [](const Endpoint& a, const Endpoint& b) {
+        if (endpointLess(a.value, a.isMin, b.value, b.isMin)) return true;
+        if (endpointLess(b.value, b.isMin, a.value, a.isMin)) return false;
+        return a.proxy < b.proxy || (a.proxy == b.proxy && a.isMin && !b.isMin);
+    });
+    
+    // Initial sweep: every min endpoint overlaps all currently open intervals
+    std::vector<int>& open = _openProxies;
+    open.clear();
+    for (const auto& e : _endpoints) {
+        if (e.isMin) {
+            for (int other : open) addCachedPair(other, e.proxy);
+            open.push_back(e.proxy);
+        } else {
+            open.erase(std::find(open.begin(), open.end(), e.proxy));
+        }
+    }
+    
+    _sapDirty = false;
+    _sapLayoutVersion = _store.getLayoutVersion();
+}
+
+void CollisionSystem::updateEndpoints() {
+    if (_sapDirty || _sapLayoutVersion != _store.getLayoutVersion()) {
+        rebuildEndpoints();
+    } else {
+        // Refresh endpoint values and repair the order with insertion sort.
+        // Bodies move very little per substep, so this is close to O(n).
+        for (auto& e : _endpoints) {
+            e.value = e.isMin ? _aabbs[e.proxy]._min.z : _aabbs[e.proxy]._max.z;
+        }
+        
+        for (size_t k = 1; k < _endpoints.size(); ++k) {
+            Endpoint e = _endpoints[k];
+            size_t j = k;
+            while (j > 0 && endpointLess(e.value, e.isMin, _endpoints[j - 1].value, _endpoints[j - 1].isMin)) {
+                const Endpoint& other = _endpoints[j - 1];
+                if (other.proxy != e.proxy) {
+                    if (e.isMin && !other.isMin) {
+                        // Our min passed their max: intervals start overlapping
+                        addCachedPair(e.proxy, other.proxy);
+                    } else if (!e.isMin && other.isMin) {
+                        // Our max passed their min: intervals separate
+                        removeCachedPair(e.proxy, other.proxy);
+                    }
+                }
+                _endpoints[j] = other;
+                --j;
+            }
+            _endpoints[j] = e;
+        }
+    }
+}
+
+void CollisionSystem::sweepAndPrune() {
+    updateEndpoints();
+    
+    // Z overlap is tracked incrementally; finish with the full box test
+    for (uint64_t key : _cachedPairKeys) {
+        int a = (int)(key >> 32);
+        int b = (int)(key & 0xffffffffu);
+        if (bothAsleep(a, b)) continue;
+        _pairTests++;
+        if (_aabbs[a].intersects(_aabbs[b])) {
+            _candidates.push_back(std::make_pair(a, b));
+        }
+    }
 }
 
 void CollisionSystem::narrowPhase(std::vector<std::pair<RigidBody*, RigidBody*>>& pairs, std::vector<Manifold>& manifolds) {
-    for (auto& pair : pairs) {
-        RigidBody* a = pair.first;
-        RigidBody* b = pair.second;
-        
-        Manifold m;
-        m.a = a;
-        m.b = b;
-        
-        bool collided = false;
-        
-        // Dispatch
-        if (a->getType() == ColliderType::SPHERE && b->getType() == ColliderType::SPHERE) {
-            collided = detectSphereSphere(a, b, m);
-        } else if (a->getType() == ColliderType::SPHERE && b->getType() == ColliderType::PLANE) {
-            collided = detectSpherePlane(a, b, m);
-        } else if (a->getType() == ColliderType::PLANE && b->getType() == ColliderType::SPHERE) {
-            collided = detectSpherePlane(b, a, m); // Swap
-            m.normal = -m.normal;
-            std::swap(m.a, m.b);
-        } else if (a->getType() == ColliderType::SPHERE && b->getType() == ColliderType::CAPSULE) {
-            collided = detectSphereCapsule(a, b, m);
-        } else if (a->getType() == ColliderType::CAPSULE && b->getType() == ColliderType::SPHERE) {
-            collided = detectSphereCapsule(b, a, m); // Swap
-            m.normal = -m.normal;
-            std::swap(m.a, m.b);
-        } else if (a->getType() == ColliderType::CAPSULE && b->getType() == ColliderType::PLANE) {
-            collided = detectCapsulePlane(a, b, m);
-        } else if (a->getType() == ColliderType::PLANE && b->getType() == ColliderType::CAPSULE) {
-            collided = detectCapsulePlane(b, a, m); // Swap
-            m.normal = -m.normal;
-            std::swap(m.a, m.b);
-        }
-        
-        if (collided) {
-            manifolds.push_back(m);
-        }
-    }
-}
-
-bool CollisionSystem::detectSphereSphere(RigidBody* s1, RigidBody* s2, Manifold& m) {
+    // Group the pairs by shape so each detector runs over one batch
+    sortByShape(pairs);
+    
+    if (pairs.size() < _parallelThreshold || !_workers || _workers->getWorkerCount() < 2) {
+        detectRange(pairs, 0, pairs.size(), manifolds);
+        return;
+    }
+    
+    // Each worker fills its own buffer over a contiguous slice of the pairs;
+    // appending the buffers in slice order gives exactly the serial result
+    auto job = [this, &pairs](int slice, size_t begin, size_t end) {
+        std::vector<Manifold>& out = _workerManifolds[slice];
+        out.clear();
+        detectRange(pairs, begin, end, out);
+    };
+    for (auto& out : _workerManifolds) out.clear();
+    _workers->parallelFor(pairs.size(), job);
+    
+    for (const auto& out : _workerManifolds) {
+        manifolds.insert(manifolds.end(), out.begin(), out.end());
+    }
+}
+
+static int shapePair(const std::pair<RigidBody*, RigidBody*>& pair) {
+    return (int)pair.first->getType() * COLLIDER_TYPE_COUNT + (int)pair.second->getType();
+}
+
+void CollisionSystem::sortByShape(std::vector<std::pair<RigidBody*, RigidBody*>>& pairs) {
+    // Stable counting sort: pairs keep their broadphase order within a batch
+    const int keys = COLLIDER_TYPE_COUNT * COLLIDER_TYPE_COUNT;
+    int offsets[keys + 1] = {};
+    for (const auto& pair : pairs) {
+        offsets[shapePair(pair) + 1]++;
+    }
+    for (int k = 0; k < keys; ++k) {
+        if (offsets[k + 1] == (int)pairs.size()) return; // Already a single batch
+        offsets[k + 1] += offsets[k];
+    }
+    
+    _sortedPairs.resize(pairs.size());
+    for (const auto& pair : pairs) {
+        _sortedPairs[offsets[shapePair(pair)]++] = pair;
+    }
+    std::copy(_sortedPairs.begin(), _sortedPairs.end(), pairs.begin());
+}
+
+void CollisionSystem::detectRange(const std::vector<std::pair<RigidBody*, RigidBody*>>& pairs, size_t begin, size_t end,
+                                  std::vector<Manifold>& manifolds) const {
+    size_t k = begin;
+    while (k < end) {
+        // One detector per run of same-shape pairs
+        int key = shapePair(pairs[k]);
+        size_t runEnd = k + 1;
+        while (runEnd < end && shapePair(pairs[runEnd]) == key) ++runEnd;
+        
+        Detector detect = DETECTORS[key / COLLIDER_TYPE_COUNT][key % COLLIDER_TYPE_COUNT];
+        if (detect) {
+            for (; k < runEnd; ++k) {
+                Manifold m;
+                m.a = pairs[k].first;
+                m.b = pairs[k].second;
+                if ((this->*detect)(m.a, m.b, m)) {
+                    manifolds.push_back(m);
+                }
+            }
+        }
+        k = runEnd;
+    }
+}
+
+template <CollisionSystem::Detector detect>
+bool CollisionSystem::detectSwapped(RigidBody* a, RigidBody* b, Manifold& m) const {
+    // Primitives report the normal from their first body to the second, so
+    // swapping the manifold's bodies is all the mirrored case needs
+    bool collided = (this->*detect)(b, a, m);
+    std::swap(m.a, m.b);
+    return collided;
+}
+
+const CollisionSystem::Detector CollisionSystem::DETECTORS[COLLIDER_TYPE_COUNT][COLLIDER_TYPE_COUNT] = {
+    // SPHERE
+    { &CollisionSystem::detectSphereSphere,
+      &CollisionSystem::detectSphereCapsule,
+      &CollisionSystem::detectSpherePlane,
+      &CollisionSystem::detectSphereBox,
+      &CollisionSystem::detectSphereTorus },
+    // CAPSULE
+    { &CollisionSystem::detectSwapped<&CollisionSystem::detectSphereCapsule>,
+      &CollisionSystem::detectCapsuleCapsule,
+      &CollisionSystem::detectCapsulePlane,
+      &CollisionSystem::detectCapsuleBox,
+      &CollisionSystem::detectCapsuleTorus },
+    // PLANE
+    { &CollisionSystem::detectSwapped<&CollisionSystem::detectSpherePlane>,
+      &CollisionSystem::detectSwapped<&CollisionSystem::detectCapsulePlane>,
+      nullptr, nullptr, nullptr },
+    // BOX
+    { &CollisionSystem::detectSwapped<&CollisionSystem::detectSphereBox>,
+      &CollisionSystem::detectSwapped<&CollisionSystem::detectCapsuleBox>,
+      nullptr, nullptr, nullptr },
+    // TORUS
+    { &CollisionSystem::detectSwapped<&CollisionSystem::detectSphereTorus>,
+      &CollisionSystem::detectSwapped<&CollisionSystem::detectCapsuleTorus>,
+      nullptr, nullptr, nullptr }
+};
+static_assert(COLLIDER_TYPE_COUNT == 5, "DETECTORS needs a row and column per ColliderType");
+
+bool CollisionSystem::detectPair(RigidBody* a, RigidBody* b, Manifold& m) const {
+    m.a = a;
+    m.b = b;
+    
+    Detector detect = DETECTORS[(int)a->getType()][(int)b->getType()];
+    return detect && (this->*detect)(a, b, m);
+}
+
+bool CollisionSystem::detectSphereSphere(RigidBody* s1, RigidBody* s2, Manifold& m) const {
     cocos2d::Vec3 d = s2->getPosition() - s1->getPosition();
     float distSq = d.lengthSquared();
     float radiusSum = s1->getRadius() + s2->getRadius();
+    float reach = radiusSum + SimplePhysics::CONTACT_SLOP;
     
-    if (distSq < radiusSum * radiusSum) {
+    if (distSq < reach * reach) {
         float dist = sqrt(distSq);
         if (dist < 0.0001f) {
             m.normal = cocos2d::Vec3::UNIT_Y;
@@ -223,22 +1456,21 @@ bool CollisionSystem::detectSphereSphere(RigidBody* s1, RigidBody* s2, Manifold&
     return false;
 }
 
-bool CollisionSystem::detectSpherePlane(RigidBody* sphere, RigidBody* plane, Manifold& m) {
+bool CollisionSystem::detectSpherePlane(RigidBody* sphere, RigidBody* plane, Manifold& m) const {
     // Plane: n.p + d = 0
     // Dist = n.p + d
     float dist = plane->getNormal().dot(sphere->getPosition()) + plane->getPlaneConstant();
     
-    // CCD: Check if we passed through the plane
-    // Currently only simple static check
-    if (dist < sphere->getRadius()) {
-        m.normal = plane->getNormal();
+    // Fast balls were already swept onto the plane (sweepFastBodies)
+    if (dist < sphere->getRadius() + SimplePhysics::CONTACT_SLOP) {
+        m.normal = -plane->getNormal();
         m.depth = sphere->getRadius() - dist;
         return true;
     }
     return false;
 }
 
-bool CollisionSystem::detectSphereCapsule(RigidBody* sphere, RigidBody* capsule, Manifold& m) {
+bool CollisionSystem::detectSphereCapsule(RigidBody* sphere, RigidBody* capsule, Manifold& m) const {
     // Segment of capsule
     cocos2d::Vec3 p = capsule->getPosition();
     cocos2d::Vec3 top = p + cocos2d::Vec3(0, capsule->getHeight()/2, 0);
@@ -256,14 +1488,86 @@ bool CollisionSystem::detectSphereCapsule(RigidBody* sphere, RigidBody* capsule,
     cocos2d::Vec3 d = sPos - closest;
     float distSq = d.lengthSquared();
     float radiusSum = sphere->getRadius() + capsule->getRadius();
+    float reach = radiusSum + SimplePhysics::CONTACT_SLOP;
     
-    if (distSq < radiusSum * radiusSum) {
+    if (distSq < reach * reach) {
+        float dist = sqrt(distSq);
+        if (dist < 0.0001f) {
+            m.normal = -cocos2d::Vec3::UNIT_X; // Arbitrary
+            m.depth = radiusSum;
+        } else {
+            m.normal = d / -dist;
+            m.depth = radiusSum - dist;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Closest points between segments p1-q1 and p2-q2
+static void closestOnSegments(const cocos2d::Vec3& p1, const cocos2d::Vec3& q1,
+                              const cocos2d::Vec3& p2, const cocos2d::Vec3& q2,
+                              cocos2d::Vec3& c1, cocos2d::Vec3& c2) {
+    const float EPSILON = 1.0e-8f;
+    cocos2d::Vec3 d1 = q1 - p1;
+    cocos2d::Vec3 d2 = q2 - p2;
+    cocos2d::Vec3 r = p1 - p2;
+    float a = d1.dot(d1);
+    float e = d2.dot(d2);
+    float f = d2.dot(r);
+    
+    float s = 0.0f;
+    float t = 0.0f;
+    if (a <= EPSILON && e <= EPSILON) {
+        // Both degenerate to points
+    } else if (a <= EPSILON) {
+        t = std::max(0.0f, std::min(1.0f, f / e));
+    } else {
+        float c = d1.dot(r);
+        if (e <= EPSILON) {
+            s = std::max(0.0f, std::min(1.0f, -c / a));
+        } else {
+            float b = d1.dot(d2);
+            float denom = a * e - b * b;
+            // Parallel segments (upright players) have no unique pair: start from p1
+            if (denom > EPSILON) {
+                s = std::max(0.0f, std::min(1.0f, (b * f - c * e) / denom));
+            }
+            t = (b * s + f) / e;
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = std::max(0.0f, std::min(1.0f, -c / a));
+            } else if (t > 1.0f) {
+                t = 1.0f;
+                s = std::max(0.0f, std::min(1.0f, (b - c) / a));
+            }
+        }
+    }
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+}
+
+bool CollisionSystem::detectCapsuleCapsule(RigidBody* c1, RigidBody* c2, Manifold& m) const {
+    cocos2d::Vec3 half1(0, c1->getHeight() / 2, 0);
+    cocos2d::Vec3 half2(0, c2->getHeight() / 2, 0);
+    cocos2d::Vec3 p1 = c1->getPosition();
+    cocos2d::Vec3 p2 = c2->getPosition();
+    
+    cocos2d::Vec3 closest1, closest2;
+    closestOnSegments(p1 - half1, p1 + half1, p2 - half2, p2 + half2, closest1, closest2);
+    
+    cocos2d::Vec3 d = closest2 - closest1;
+    float distSq = d.lengthSquared();
+    float radiusSum = c1->getRadius() + c2->getRadius();
+    float reach = radiusSum + SimplePhysics::CONTACT_SLOP;
+    
+    if (distSq < reach * reach) {
         float dist = sqrt(distSq);
         if (dist < 0.0001f) {
             m.normal = cocos2d::Vec3::UNIT_X; // Arbitrary
             m.depth = radiusSum;
         } else {
-            m.normal = d / dist;
+            m.normal = d * (1.0f / dist);
             m.depth = radiusSum - dist;
         }
         return true;
@@ -271,7 +1575,7 @@ bool CollisionSystem::detectSphereCapsule(RigidBody* sphere, RigidBody* capsule,
     return false;
 }
 
-bool CollisionSystem::detectCapsulePlane(RigidBody* capsule, RigidBody* plane, Manifold& m) {
+bool CollisionSystem::detectCapsulePlane(RigidBody* capsule, RigidBody* plane, Manifold& m) const {
     // Check top and bottom sphere of capsule
     float halfHeight = capsule->getHeight() / 2;
     cocos2d::Vec3 pos = capsule->getPosition();
@@ -287,7 +1591,7 @@ bool CollisionSystem::detectCapsulePlane(RigidBody* capsule, RigidBody* plane, M
     // We prioritize the deepest penetration
     
     if (hitBottom) {
-        m.normal = plane->getNormal();
+        m.normal = -plane->getNormal();
         m.depth = radius - distBottom;
         return true;
     }
@@ -296,62 +1600,563 @@ bool CollisionSystem::detectCapsulePlane(RigidBody* capsule, RigidBody* plane, M
     return false;
 }
 
-void CollisionSystem::resolveCollisions(const std::vector<Manifold>& manifolds) {
-    for (const auto& m : manifolds) {
-        RigidBody* a = m.a;
-        RigidBody* b = m.b;
+// Closest point of an oriented box to 'point'. Returns false (and the
+// shallowest way out instead) when the point is inside the box. 'outward'
+// is set either way: the normal of the face the point is nearest to (or
+// furthest beyond), for when the closest point is the point itself.
+static bool closestOnBox(RigidBody* box, const cocos2d::Vec3& point, cocos2d::Vec3& closest,
+                         cocos2d::Vec3& outward, float& insideDepth) {
+    cocos2d::Vec3 center = box->getPosition();
+    cocos2d::Vec3 d = point - center;
+    const cocos2d::Vec3& h = box->getHalfExtents();
+    float half[3] = { h.x, h.y, h.z };
+    
+    bool inside = true;
+    float minGap = 0.0f;
+    int minAxis = 0;
+    float minSign = 1.0f;
+    closest = center;
+    for (int k = 0; k < 3; ++k) {
+        const cocos2d::Vec3& axis = box->getBoxAxis(k);
+        float local = d.dot(axis);
+        float clamped = std::max(-half[k], std::min(half[k], local));
+        if (clamped != local) inside = false;
+        closest += axis * clamped;
         
-        // 1. Positional Correction (prevent sinking)
-        const float percent = 0.8f; // Penetration percentage to correct
-        const float slop = 0.01f;   // Penetration allowance
-        cocos2d::Vec3 correction = m.normal * (std::max(m.depth - slop, 0.0f) / (a->getInvMass() + b->getInvMass())) * percent;
+        float gap = half[k] - std::abs(local);
+        if (k == 0 || gap < minGap) {
+            minGap = gap;
+            minAxis = k;
+            minSign = local < 0.0f ? -1.0f : 1.0f;
+        }
+    }
+    outward = box->getBoxAxis(minAxis) * minSign;
+    if (inside) {
+        insideDepth = minGap;
+    }
+    return !inside;
+}
+
+bool CollisionSystem::detectSphereBox(RigidBody* sphere, RigidBody* box, Manifold& m) const {
+    cocos2d::Vec3 center = sphere->getPosition();
+    float radius = sphere->getRadius();
+    
+    cocos2d::Vec3 closest, outward;
+    float insideDepth;
+    if (closestOnBox(box, center, closest, outward, insideDepth)) {
+        cocos2d::Vec3 d = closest - center;
+        float distSq = d.lengthSquared();
+        float reach = radius + SimplePhysics::CONTACT_SLOP;
+        if (distSq >= reach * reach) return false;
         
-        if (!a->isStatic()) a->setPosition(a->getPosition() - correction * a->getInvMass());
-        if (!b->isStatic()) b->setPosition(b->getPosition() + correction * b->getInvMass());
+        float dist = std::sqrt(distSq);
+        if (dist < 0.0001f) {
+            // Center on the surface, sunk in by the whole radius: out through that face
+            m.normal = -outward;
+            m.depth = radius;
+            return true;
+        }
+        m.normal = d / dist;
+        m.depth = radius - dist;
+        return true;
+    }
+    
+    // Center inside the box: leave through the nearest face
+    m.normal = -outward;
+    m.depth = radius + insideDepth;
+    return true;
+}
+
+bool CollisionSystem::detectCapsuleBox(RigidBody* capsule, RigidBody* box, Manifold& m) const {
+    cocos2d::Vec3 p = capsule->getPosition();
+    cocos2d::Vec3 half(0, capsule->getHeight() / 2, 0);
+    cocos2d::Vec3 bottom = p - half;
+    cocos2d::Vec3 segment = half * 2.0f;
+    
+    // Distance to a convex box is convex along the segment: narrow down
+    // the closest point with a fixed number of ternary search steps
+    float lo = 0.0f;
+    float hi = 1.0f;
+    cocos2d::Vec3 closest, outward;
+    float insideDepth;
+    for (int k = 0; k < 24; ++k) {
+        float t1 = lo + (hi - lo) / 3.0f;
+        float t2 = hi - (hi - lo) / 3.0f;
+        cocos2d::Vec3 p1 = bottom + segment * t1;
+        cocos2d::Vec3 p2 = bottom + segment * t2;
+        float d1 = closestOnBox(box, p1, closest, outward, insideDepth) ? p1.distanceSquared(closest) : -insideDepth;
+        float d2 = closestOnBox(box, p2, closest, outward, insideDepth) ? p2.distanceSquared(closest) : -insideDepth;
+        if (d1 < d2) hi = t2; else lo = t1;
+    }
+    
+    // Then it is a sphere of the capsule's radius at that point
+    cocos2d::Vec3 point = bottom + segment * ((lo + hi) * 0.5f);
+    float radius = capsule->getRadius();
+    if (closestOnBox(box, point, closest, outward, insideDepth)) {
+        cocos2d::Vec3 d = closest - point;
+        float distSq = d.lengthSquared();
+        float reach = radius + SimplePhysics::CONTACT_SLOP;
+        if (distSq >= reach * reach) return false;
         
-        // 2. Velocity Resolution
-        cocos2d::Vec3 rv = b->getVelocity() - a->getVelocity();
-        float velAlongNormal = rv.dot(m.normal);
+        float dist = std::sqrt(distSq);
+        if (dist < 0.0001f) {
+            m.normal = -outward;
+            m.depth = radius;
+            return true;
+        }
+        m.normal = d / dist;
+        m.depth = radius - dist;
+        return true;
+    }
+    m.normal = -outward;
+    m.depth = radius + insideDepth;
+    return true;
+}
+
+
+bool CollisionSystem::detectSphereTorus(RigidBody* sphere, RigidBody* torus, Manifold& m) const {
+    // A sphere against a torus is a sphere against the tube's cross section
+    // at the nearest point of the center circle
+    cocos2d::Vec3 center = sphere->getPosition();
+    cocos2d::Vec3 d = closestOnRing(torus, center) - center;
+    float distSq = d.lengthSquared();
+    float radiusSum = sphere->getRadius() + torus->getRadius();
+    float reach = radiusSum + SimplePhysics::CONTACT_SLOP;
+    
+    if (distSq < reach * reach) {
+        float dist = sqrt(distSq);
+        if (dist < 0.0001f) {
+            m.normal = -cocos2d::Vec3::UNIT_Y;
+            m.depth = radiusSum;
+        } else {
+            m.normal = d * (1.0f / dist);
+            m.depth = radiusSum - dist;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool CollisionSystem::detectCapsuleTorus(RigidBody* capsule, RigidBody* torus, Manifold& m) const {
+    // The ring is horizontal and the capsule upright, so the nearest point of
+    // the ring is the same for the whole segment; clamp its height onto it
+    cocos2d::Vec3 p = capsule->getPosition();
+    cocos2d::Vec3 ring = closestOnRing(torus, p);
+    float halfHeight = capsule->getHeight() / 2;
+    cocos2d::Vec3 closest(p.x, std::max(p.y - halfHeight, std::min(p.y + halfHeight, ring.y)), p.z);
+    
+    cocos2d::Vec3 d = ring - closest;
+    float distSq = d.lengthSquared();
+    float radiusSum = capsule->getRadius() + torus->getRadius();
+    float reach = radiusSum + SimplePhysics::CONTACT_SLOP;
+    
+    if (distSq < reach * reach) {
+        float dist = sqrt(distSq);
+        if (dist < 0.0001f) {
+            m.normal = -cocos2d::Vec3::UNIT_Y;
+            m.depth = radiusSum;
+        } else {
+            m.normal = d * (1.0f / dist);
+            m.depth = radiusSum - dist;
+        }
+        return true;
+    }
+    return false;
+}
+
+static uint64_t contactKey(BodyStore::Handle a, BodyStore::Handle b) {
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+void CollisionSystem::resolveCollisions(const std::vector<Manifold>& manifolds) {
+    BodyStore& s = _store;
+    
+    // 1. Set up contacts: positional correction, restitution target, warm start
+    _contacts.clear();
+    for (const auto& m : manifolds) {
+        BodyStore::Handle ha = m.a->getHandle();
+        BodyStore::Handle hb = m.b->getHandle();
+        int a = (int)s.indexOf(ha);
+        int b = (int)s.indexOf(hb);
         
-        if (velAlongNormal > 0) continue; // Moving away
+        // Statics are immovable whatever mass they were given
+        float invA = (s.flags[a] & BodyStore::FLAG_STATIC) ? 0.0f : s.invMass[a];
+        float invB = (s.flags[b] & BodyStore::FLAG_STATIC) ? 0.0f : s.invMass[b];
+        if (invA + invB <= 0.0f) continue;
         
-        float e = std::min(a->getMaterial().restitution, b->getMaterial().restitution);
+        Contact c;
+        c.a = a;
+        c.b = b;
+        c.normal = m.normal;
+        c.invMassA = invA;
+        c.invMassB = invB;
+        c.effMass = 1.0f / (invA + invB);
+        c.friction = std::sqrt(m.a->getMaterial().friction * m.b->getMaterial().friction);
         
-        float j = -(1 + e) * velAlongNormal;
-        j /= a->getInvMass() + b->getInvMass();
+        // Push apart (prevents sinking); velocities are solved separately below
+        float push = std::max(m.depth - SimplePhysics::CONTACT_SLOP, 0.0f) * c.effMass * SimplePhysics::CONTACT_CORRECTION;
+        s.posX[a] -= m.normal.x * push * invA; s.posY[a] -= m.normal.y * push * invA; s.posZ[a] -= m.normal.z * push * invA;
+        s.posX[b] += m.normal.x * push * invB; s.posY[b] += m.normal.y * push * invB; s.posZ[b] += m.normal.z * push * invB;
         
-        cocos2d::Vec3 impulse = m.normal * j;
+        // Bounce only off real impacts, so resting contacts don't jitter
+        cocos2d::Vec3 rv(s.velX[b] - s.velX[a], s.velY[b] - s.velY[a], s.velZ[b] - s.velZ[a]);
+        float approach = rv.dot(m.normal);
+        float e = std::min(s.restitution[a], s.restitution[b]);
+        c.bounce = approach < -SimplePhysics::RESTITUTION_VELOCITY ? -e * approach : 0.0f;
+        c.approaching = approach < 0.0f;
         
-        if (!a->isStatic()) a->setVelocity(a->getVelocity() - impulse * a->getInvMass());
-        if (!b->isStatic()) b->setVelocity(b->getVelocity() + impulse * b->getInvMass());
+        // Start from the impulses this pair ended the last step with
+        c.normalImpulse = 0.0f;
+        c.tangentImpulse = cocos2d::Vec3::ZERO;
+        uint32_t slot;
+        if (_contactIndex.find(contactKey(ha, hb), slot)) {
+            const CachedContact& cached = _contactCache[slot];
+            float sign = cached.a == ha ? 1.0f : -1.0f;
+            if (cached.normal.dot(m.normal) * sign > SimplePhysics::WARM_START_NORMAL_DOT) {
+                c.normalImpulse = cached.normalImpulse;
+                cocos2d::Vec3 t = cached.tangentImpulse * sign;
+                c.tangentImpulse = t - m.normal * t.dot(m.normal);
+            }
+        }
         
-        // Callback
-        if (a->onCollision) a->onCollision(b, std::abs(j));
-        if (b->onCollision) b->onCollision(a, std::abs(j));
-
-        // 3. Friction
-        cocos2d::Vec3 tangent = rv - m.normal * rv.dot(m.normal);
-        if (tangent.lengthSquared() > 0.0001f) {
-            tangent.normalize();
-            float jt = -rv.dot(tangent);
-            jt /= a->getInvMass() + b->getInvMass();
+        c.ownerA = m.a;
+        c.ownerB = m.b;
+        _contacts.push_back(c);
+    }
+    
+    // Warm start only once every restitution target was measured on the incoming velocities
+    for (const auto& c : _contacts) {
+        applyImpulse(c, c.normal * c.normalImpulse + c.tangentImpulse);
+    }
+    
+    // 2. Sequential impulses, clamping the accumulated (not the incremental) impulse
+    for (int iteration = 0; iteration < SimplePhysics::SOLVER_ITERATIONS; ++iteration) {
+        for (auto& c : _contacts) {
+            cocos2d::Vec3 rv(s.velX[c.b] - s.velX[c.a], s.velY[c.b] - s.velY[c.a], s.velZ[c.b] - s.velZ[c.a]);
             
-            float mu = std::sqrt(a->getMaterial().friction * b->getMaterial().friction);
+            // Normal: never pull
+            float jn = (c.bounce - rv.dot(c.normal)) * c.effMass;
+            float normalImpulse = std::max(c.normalImpulse + jn, 0.0f);
+            jn = normalImpulse - c.normalImpulse;
+            c.normalImpulse = normalImpulse;
+            cocos2d::Vec3 impulse = c.normal * jn;
             
-            // Coulomb's Law
-            cocos2d::Vec3 frictionImpulse;
-            if (std::abs(jt) < j * mu) {
-                frictionImpulse = tangent * jt;
-            } else {
-                frictionImpulse = tangent * (-j * mu);
+            // Friction: Coulomb cone around the current normal impulse
+            rv += impulse * (c.invMassA + c.invMassB);
+            cocos2d::Vec3 slide = rv - c.normal * rv.dot(c.normal);
+            cocos2d::Vec3 tangentImpulse = c.tangentImpulse - slide * c.effMass;
+            float maxFriction = c.friction * c.normalImpulse;
+            float lengthSq = tangentImpulse.lengthSquared();
+            if (lengthSq > maxFriction * maxFriction) {
+                tangentImpulse *= maxFriction / std::sqrt(lengthSq);
             }
+            impulse += tangentImpulse - c.tangentImpulse;
+            c.tangentImpulse = tangentImpulse;
             
-            if (!a->isStatic()) a->setVelocity(a->getVelocity() - frictionImpulse * a->getInvMass());
-            if (!b->isStatic()) b->setVelocity(b->getVelocity() + frictionImpulse * b->getInvMass());
+            applyImpulse(c, impulse);
         }
     }
+    
+    // 3. Remember the impulses for the next step; report impacts
+    for (const auto& c : _contacts) {
+        BodyStore::Handle ha = c.ownerA->getHandle();
+        BodyStore::Handle hb = c.ownerB->getHandle();
+        uint64_t key = contactKey(ha, hb);
+        uint32_t slot;
+        if (!_contactIndex.find(key, slot)) {
+            slot = (uint32_t)_contactCache.size();
+            _contactCache.push_back(CachedContact());
+            _contactIndex.set(key, slot);
+        }
+        CachedContact& cached = _contactCache[slot];
+        cached.key = key;
+        cached.a = ha;
+        cached.normal = c.normal;
+        cached.normalImpulse = c.normalImpulse;
+        cached.tangentImpulse = c.tangentImpulse;
+        cached.step = _solverStep;
+        
+        // Callbacks run after the step (dispatchEvents)
+        if (c.approaching && (c.ownerA->onCollision || c.ownerB->onCollision)) {
+            _events.record(ha, hb, c.normalImpulse, c.normal, _frameSubstep,
+                           (s.flags[c.a] & BodyStore::FLAG_KINEMATIC) != 0,
+                           (s.flags[c.b] & BodyStore::FLAG_KINEMATIC) != 0);
+        }
+    }
+}
+
+void CollisionSystem::applyImpulse(const Contact& c, const cocos2d::Vec3& impulse) {
+    BodyStore& s = _store;
+    s.velX[c.a] -= impulse.x * c.invMassA; s.velY[c.a] -= impulse.y * c.invMassA; s.velZ[c.a] -= impulse.z * c.invMassA;
+    s.velX[c.b] += impulse.x * c.invMassB; s.velY[c.b] += impulse.y * c.invMassB; s.velZ[c.b] += impulse.z * c.invMassB;
+}
+
+void CollisionSystem::pruneContactCache() {
+    // Drop pairs that weren't in contact during the step that just ended
+    size_t kept = 0;
+    _contactIndex.clear();
+    for (size_t k = 0; k < _contactCache.size(); ++k) {
+        if (_contactCache[k].step != _solverStep) continue;
+        _contactCache[kept] = _contactCache[k];
+        _contactIndex.set(_contactCache[kept].key, (uint32_t)kept);
+        kept++;
+    }
+    _contactCache.resize(kept);
+    _solverStep++;
+}
+
+void CollisionSystem::dispatchEvents() {
+    if (_events.empty()) return;
+    
+    // Callbacks may add / remove bodies or record new contacts; work on a copy
+    // and look each body up again, skipping any that were removed
+    _events.take(_dispatching);
+    for (const auto& e : _dispatching) {
+        if (!_store.isAlive(e.a) || !_store.isAlive(e.b)) continue;
+        RigidBody* a = _store.owner[_store.indexOf(e.a)];
+        RigidBody* b = _store.owner[_store.indexOf(e.b)];
+        if (a->onCollision && !e.heldA) a->onCollision(b, e.impulse);
+        
+        if (!_store.isAlive(e.a) || !_store.isAlive(e.b)) continue;
+        a = _store.owner[_store.indexOf(e.a)];
+        b = _store.owner[_store.indexOf(e.b)];
+        if (b->onCollision && !e.heldB) b->onCollision(a, e.impulse);
+    }
+    _dispatching.clear();
 }
 
 bool CollisionSystem::checkTrigger(const cocos2d::Vec3& point, const cocos2d::AABB& triggerBox) {
     return triggerBox.containPoint(point);
 }
+
+// Whether the segment start..start + motion, grown by 'radius', can touch 'box'
+static bool segmentOverlapsBox(const cocos2d::Vec3& start, const cocos2d::Vec3& motion, float radius,
+                               const cocos2d::AABB& box) {
+    const float s[3] = { start.x, start.y, start.z };
+    const float m[3] = { motion.x, motion.y, motion.z };
+    const float lo[3] = { box._min.x - radius, box._min.y - radius, box._min.z - radius };
+    const float hi[3] = { box._max.x + radius, box._max.y + radius, box._max.z + radius };
+    
+    float enter = 0.0f;
+    float exit = 1.0f;
+    for (int k = 0; k < 3; ++k) {
+        if (std::abs(m[k]) < 1.0e-8f) {
+            if (s[k] < lo[k] || s[k] > hi[k]) return false;
+            continue;
+        }
+        float t0 = (lo[k] - s[k]) / m[k];
+        float t1 = (hi[k] - s[k]) / m[k];
+        if (t0 > t1) std::swap(t0, t1);
+        enter = std::max(enter, t0);
+        exit = std::min(exit, t1);
+        if (enter > exit) return false;
+    }
+    return true;
+}
+
+// Distance from 'point' to the surface of 'body' (negative inside), with the
+// closest surface point and the outward normal there
+static float distanceToShape(RigidBody* body, const cocos2d::Vec3& point,
+                             cocos2d::Vec3& closest, cocos2d::Vec3& normal) {
+    cocos2d::Vec3 pos = body->getPosition();
+    cocos2d::Vec3 core = pos; // Closest point of the shape's core: center, axis segment or ring
+    
+    switch (body->getType()) {
+        case ColliderType::PLANE: {
+            normal = body->getNormal();
+            float d = normal.dot(point) + body->getPlaneConstant();
+            closest = point - normal * d;
+            return d;
+        }
+        case ColliderType::BOX: {
+            cocos2d::Vec3 outward;
+            float insideDepth;
+            if (!closestOnBox(body, point, closest, outward, insideDepth)) {
+                normal = outward;
+                closest = point + outward * insideDepth;
+                return -insideDepth;
+            }
+            cocos2d::Vec3 d = point - closest;
+            float dist = d.length();
+            if (dist > 0.0001f) {
+                normal = d / dist;
+                return dist;
+            }
+            // On the surface: the face the point sticks out of the most
+            cocos2d::Vec3 local = point - pos;
+            const cocos2d::Vec3& h = body->getHalfExtents();
+            float half[3] = { h.x, h.y, h.z };
+            float best = -1.0f;
+            for (int k = 0; k < 3; ++k) {
+                float along = local.dot(body->getBoxAxis(k));
+                float ratio = std::abs(along) / half[k];
+                if (ratio > best) {
+                    best = ratio;
+                    normal = body->getBoxAxis(k) * (along < 0.0f ? -1.0f : 1.0f);
+                }
+            }
+            return 0.0f;
+        }
+        case ColliderType::CAPSULE: {
+            float half = body->getHeight() / 2;
+            core.y += std::max(-half, std::min(half, point.y - pos.y));
+            break;
+        }
+        case ColliderType::TORUS:
+            core = closestOnRing(body, point);
+            break;
+        case ColliderType::SPHERE:
+            break;
+    }
+    cocos2d::Vec3 d = point - core;
+    float dist = d.length();
+    normal = dist > 0.0001f ? d / dist : cocos2d::Vec3::UNIT_Y;
+    closest = core + normal * body->getRadius();
+    return dist - body->getRadius();
+}
+
+void CollisionSystem::prepareQueries() {
+    // Bodies added since the last step are visible to queries right away.
+    // The next step still counts as a change for the allocation guard.
+    if (!isPartitionCurrent()) {
+        updatePartition();
+        _settledSteps = 0;
+    }
+    if (!_queryBoundsCurrent) refreshBroadPhase();
+}
+
+void CollisionSystem::addQueryCandidate(int j, const cocos2d::AABB& bounds, int mask) {
+    if (!(_store.owner[j]->getCategoryMask() & mask)) return;
+    if (!_aabbs[j].intersects(bounds)) return;
+    _queryBodies.push_back(j);
+    _queryBoxes.push_back(_aabbs[j]);
+}
+
+void CollisionSystem::gatherQueryCandidates(const cocos2d::AABB& bounds, int mask) {
+    _queryBodies.clear();
+    _queryBoxes.clear();
+    
+    for (int u : _staticUnbounded) {
+        addQueryCandidate(u, bounds, mask);
+    }
+    _staticHits.clear();
+    _staticBVH.query(bounds, _staticHits);
+    for (int j : _staticHits) {
+        addQueryCandidate(j, bounds, mask);
+    }
+    
+    // Dynamic bodies from the broadphase, as refreshBroadPhase() left it
+    if (_broadPhaseType == BroadPhase::GRID) {
+        // A body spanning several of the cells is taken from the lowest one
+        int x0 = cellX(bounds._min.x), x1 = cellX(bounds._max.x);
+        int z0 = cellZ(bounds._min.z), z1 = cellZ(bounds._max.z);
+        for (int z = z0; z <= z1; ++z) {
+            for (int x = x0; x <= x1; ++x) {
+                int cell = z * GRID_COLS + x;
+                for (int p = _cellStart[cell]; p < _cellStart[cell + 1]; ++p) {
+                    int j = _cellEntries[p];
+                    const CellRange& r = _cellRanges[j];
+                    if (std::max(r.x0, x0) != x || std::max(r.z0, z0) != z) continue;
+                    addQueryCandidate(j, bounds, mask);
+                }
+            }
+        }
+        for (int j : _unbounded) {
+            addQueryCandidate(j, bounds, mask);
+        }
+    } else {
+        // A body overlapping 'bounds' along Z starts at most the widest
+        // body's span before it: only that window of endpoints is walked
+        float from = bounds._min.z - _maxSpanZ;
+        auto it = std::lower_bound(_endpoints.begin(), _endpoints.end(), from,
+                                   [](const Endpoint& e, float value) { return e.value < value; });
+        for (; it != _endpoints.end() && it->value <= bounds._max.z; ++it) {
+            if (it->isMin) addQueryCandidate(it->proxy, bounds, mask);
+        }
+    }
+}
+
+bool CollisionSystem::castCandidates(const Ray& ray, float radius, RaycastHit& hit) const {
+    hit.body = nullptr;
+    float length = ray.direction.length();
+    if (length < 1.0e-6f || ray.maxDistance <= 0.0f) return false;
+    
+    cocos2d::Vec3 motion = ray.direction * (ray.maxDistance / length);
+    float best = 1.0f;
+    float toi;
+    RigidBody* nearest = nullptr;
+    for (size_t k = 0; k < _queryBodies.size(); ++k) {
+        if (!segmentOverlapsBox(ray.origin, motion, radius, _queryBoxes[k])) continue;
+        RigidBody* body = _store.owner[_queryBodies[k]];
+        if (sweepShape(body, ray.origin, motion, radius, toi) && toi <= best) {
+            best = toi;
+            nearest = body;
+        }
+    }
+    if (!nearest) return false;
+    
+    cocos2d::Vec3 center = ray.origin + motion * best;
+    hit.body = nearest;
+    hit.distance = best * ray.maxDistance;
+    distanceToShape(nearest, center, hit.point, hit.normal);
+    return true;
+}
+
+static cocos2d::AABB castBounds(const CollisionSystem::Ray& ray, float radius) {
+    float length = ray.direction.length();
+    cocos2d::Vec3 end = length > 1.0e-6f ? ray.origin + ray.direction * (ray.maxDistance / length) : ray.origin;
+    cocos2d::Vec3 extent(radius, radius, radius);
+    cocos2d::AABB bounds(ray.origin - extent, ray.origin + extent);
+    bounds.merge(cocos2d::AABB(end - extent, end + extent));
+    return bounds;
+}
+
+bool CollisionSystem::raycast(const cocos2d::Vec3& origin, const cocos2d::Vec3& direction, float maxDistance,
+                              RaycastHit& hit, int mask) {
+    return sphereCast(origin, direction, 0.0f, maxDistance, hit, mask);
+}
+
+bool CollisionSystem::sphereCast(const cocos2d::Vec3& origin, const cocos2d::Vec3& direction, float radius,
+                                 float maxDistance, RaycastHit& hit, int mask) {
+    Ray ray = { origin, direction, maxDistance };
+    prepareQueries();
+    gatherQueryCandidates(castBounds(ray, radius), mask);
+    return castCandidates(ray, radius, hit);
+}
+
+size_t CollisionSystem::raycast(const std::vector<Ray>& rays, std::vector<RaycastHit>& hits, int mask) {
+    return sphereCast(rays, 0.0f, hits, mask);
+}
+
+size_t CollisionSystem::sphereCast(const std::vector<Ray>& rays, float radius, std::vector<RaycastHit>& hits,
+                                   int mask) {
+    hits.resize(rays.size());
+    if (rays.empty()) return 0;
+    
+    // Candidates per ray: rays fanned out over the court would share few.
+    // The scratch lists are reused, so the batch doesn't allocate.
+    prepareQueries();
+    size_t hitCount = 0;
+    for (size_t k = 0; k < rays.size(); ++k) {
+        gatherQueryCandidates(castBounds(rays[k], radius), mask);
+        if (castCandidates(rays[k], radius, hits[k])) hitCount++;
+    }
+    return hitCount;
+}
+
+size_t CollisionSystem::overlapSphere(const cocos2d::Vec3& center, float radius, std::vector<RigidBody*>& out,
+                                      int mask) {
+    cocos2d::Vec3 extent(radius, radius, radius);
+    prepareQueries();
+    gatherQueryCandidates(cocos2d::AABB(center - extent, center + extent), mask);
+    
+    size_t before = out.size();
+    cocos2d::Vec3 closest, normal;
+    for (int j : _queryBodies) {
+        RigidBody* body = _store.owner[j];
+        if (distanceToShape(body, center, closest, normal) <= radius) {
+            out.push_back(body);
+        }
+    }
+    return out.size() - before;
+}
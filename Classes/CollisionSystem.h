@@ -2,32 +2,110 @@
 #define __COLLISION_SYSTEM_H__
 
 #include "RigidBody.h"
+#include "BodyStore.h"
+#include "StaticBVH.h"
+#include "PairTable.h"
+#include "CollisionEventQueue.h"
+#include "WorkerPool.h"
+#include "StateHash.h"
 #include <vector>
 #include <utility>
+#include <cstdint>
 
 class CollisionSystem {
 public:
+    enum class BroadPhase {
+        GRID,            // Uniform grid rebuilt every substep
+        SWEEP_AND_PRUNE  // Persistent sorted endpoints, repaired incrementally
+    };
+
+    // Worlds are independent: bodies belong to the world they were added to.
+    // getInstance() is the game's default world; extra worlds (headless
+    // matches, one per thread) narrowphase on their own thread and don't
+    // report to the PerformanceMonitor.
+    CollisionSystem();
+    ~CollisionSystem();
+    CollisionSystem(const CollisionSystem&) = delete;
+    CollisionSystem& operator=(const CollisionSystem&) = delete;
+
     static CollisionSystem* getInstance();
 
     void reset();
 
     void addBody(RigidBody* body);
     void removeBody(RigidBody* body);
+    size_t getBodyCount() const { return _store.size(); }
     
     void update(float dt);
     
     // Get alpha for interpolation (0.0 - 1.0)
     float getAlpha() const;
 
+    void setBroadPhase(BroadPhase type);
+    BroadPhase getBroadPhase() const { return _broadPhaseType; }
+
+    // Resting bodies fall asleep and are skipped until something wakes them
+    void setSleepEnabled(bool enabled);
+    bool isSleepEnabled() const { return _sleepEnabled; }
+
+    // Merge repeated contacts of a pair within one frame into one onCollision call
+    void setEventCoalescing(bool enabled) { _events.setCoalescing(enabled); }
+    bool isEventCoalescing() const { return _events.isCoalescing(); }
+
+    // Narrowphase runs on the worker pool once a substep has at least this
+    // many candidate pairs (results are identical either way)
+    void setParallelThreshold(size_t minPairs) { _parallelThreshold = minPairs; }
+    size_t getParallelThreshold() const { return _parallelThreshold; }
+
+    // Flat copy of the simulation state: body motion and sleep state, the
+    // solver's warm-start cache, the broadphase order and the accumulator.
+    // Shapes, masses and materials are configuration and aren't captured.
+    // Reuse one Snapshot: once its buffer fits the world, snapshot() doesn't allocate.
+    class Snapshot {
+    public:
+        size_t getSize() const { return _data.size(); }
+    private:
+        friend class CollisionSystem;
+        std::vector<unsigned char> _data;
+    };
+    void snapshot(Snapshot& out) const;
+    // Fails, leaving the world untouched, if bodies were added or removed since
+    bool restore(const Snapshot& snapshot);
+    // Adds everything snapshot() captures to 'hash'
+    void hashState(StateHash& hash) const;
+
+    // Scene queries against every body whose category is in 'mask'. Statics
+    // come from the BVH, dynamic bodies from the broadphase, which is brought
+    // up to date with the solver's output at the end of each step: a body
+    // moved by hand (setPosition) since is found where the step left it.
+    // Bodies a cast starts inside are ignored.
+    struct Ray {
+        cocos2d::Vec3 origin;
+        cocos2d::Vec3 direction;    // Needn't be normalized
+        float maxDistance;
+    };
+    struct RaycastHit {
+        RigidBody* body;            // Null on a miss
+        cocos2d::Vec3 point;        // On the body's surface
+        cocos2d::Vec3 normal;       // Surface normal at 'point'
+        float distance;             // Travelled by the ray (or the cast sphere's center)
+    };
+    bool raycast(const cocos2d::Vec3& origin, const cocos2d::Vec3& direction, float maxDistance,
+                 RaycastHit& hit, int mask = ~0);
+    bool sphereCast(const cocos2d::Vec3& origin, const cocos2d::Vec3& direction, float radius,
+                    float maxDistance, RaycastHit& hit, int mask = ~0);
+    // Appends the bodies touching the sphere; returns how many were added
+    size_t overlapSphere(const cocos2d::Vec3& center, float radius, std::vector<RigidBody*>& out, int mask = ~0);
+    // Batched: hits[k] answers rays[k]. Returns the number of rays that hit something.
+    size_t raycast(const std::vector<Ray>& rays, std::vector<RaycastHit>& hits, int mask = ~0);
+    size_t sphereCast(const std::vector<Ray>& rays, float radius, std::vector<RaycastHit>& hits, int mask = ~0);
+
     // Check if a point is inside a trigger (for Hoop)
     bool checkTrigger(const cocos2d::Vec3& point, const cocos2d::AABB& triggerBox);
 
 private:
-    CollisionSystem();
-    ~CollisionSystem();
-    
     static CollisionSystem* _instance;
-    std::vector<RigidBody*> _bodies;
+    BodyStore _store;
     
     float _accumulator;
     
@@ -38,21 +116,200 @@ private:
         float depth;
     };
     
-    // Cache for temporal coherence
+    // Per-step buffers, kept between steps so the steady state doesn't allocate
+    // (checked by PhysicsAllocGuard once the world has settled)
+    std::vector<std::pair<RigidBody*, RigidBody*>> _pairs;
+    std::vector<std::pair<RigidBody*, RigidBody*>> _sortedPairs; // Scratch for sortByShape
+    std::vector<Manifold> _manifolds;
+    std::vector<cocos2d::AABB> _staticBoxes;
+    std::vector<int> _staticIds;
+    std::vector<int> _openProxies;
+    int _settledSteps;                      // Fixed steps since bodies were last added / removed
+    
+    struct SnapshotHeader;
+    static size_t snapshotSize(const SnapshotHeader& header);
+    
+    // Contacts for onCollision, recorded by the solver and dispatched after the frame's steps
+    CollisionEventQueue _events;
+    std::vector<CollisionEvent> _dispatching;
+    int _frameSubstep;                      // Substeps run so far this frame
+    
+    // Parallel narrowphase: one manifold buffer per worker slice
+    WorkerPool* _workers;
+    std::vector<std::vector<Manifold>> _workerManifolds;
+    size_t _parallelThreshold;
+    
+    // Contact solver: sequential impulses, warm started from the previous step
+    struct Contact {
+        int a, b;                       // Dense store indices
+        RigidBody* ownerA;
+        RigidBody* ownerB;
+        cocos2d::Vec3 normal;           // From a towards b
+        float invMassA, invMassB;       // 0 for statics
+        float effMass;
+        float friction;
+        float bounce;                   // Target separating speed (restitution)
+        bool approaching;
+        float normalImpulse;            // Accumulated over the iterations
+        cocos2d::Vec3 tangentImpulse;
+    };
+    struct CachedContact {
+        uint64_t key;
+        BodyStore::Handle a;            // Body the normal points away from
+        cocos2d::Vec3 normal;
+        float normalImpulse;
+        cocos2d::Vec3 tangentImpulse;
+        uint32_t step;                  // Last fixed step the pair was in contact
+    };
+    std::vector<Contact> _contacts;
+    std::vector<CachedContact> _contactCache;
+    PairTable _contactIndex;                // Pair key -> slot in _contactCache
+    uint32_t _solverStep;
+    
+    BroadPhase _broadPhaseType;
+    
+    // Static / dynamic partition. Only dynamic bodies go through the
+    // broadphase; statics are built into a BVH once and queried per dynamic body.
+    std::vector<int> _dynamicBodies;        // Dense indices of non-static bodies, ascending
+    std::vector<int> _staticUnbounded;      // Static planes, tested against every dynamic body
+    std::vector<int> _staticHits;           // Scratch for BVH queries
+    std::vector<int> _fastBodies;           // Scratch: awake CCD bodies that moved far this substep
+    std::vector<int> _queryBodies;          // Scratch for scene queries: candidates passing the mask
+    std::vector<cocos2d::AABB> _queryBoxes; // Parallel to _queryBodies
+    
+    // Adaptive substepping: bodies close to statics get their own substeps
+    std::vector<int> _substepped;           // Dense indices stepped separately this step
+    std::vector<uint8_t> _substepCount;     // Per body, 0 unless listed in _substepped
+    std::vector<std::pair<int, int>> _stepRuns; // _awakeRuns minus the substepped and ballistic bodies
+    
+    // Ballistic fast path: a ball in free flight, clear of every collider for
+    // the whole step, follows its parabola in closed form and skips CCD and
+    // the static queries
+    std::vector<int> _ballistic;            // Dense indices advanced in closed form this step
+    std::vector<uint8_t> _isBallistic;      // Per body, 1 if listed in _ballistic
+    std::vector<std::pair<RigidBody*, RigidBody*>> _staticPairs;
+    std::vector<Manifold> _staticManifolds;
+    int _integrations;
+    StaticBVH _staticBVH;
+    bool _partitionDirty;
+    uint32_t _partitionLayoutVersion;
+    uint32_t _partitionStaticVersion;
+    
+    // Awake subset of _dynamicBodies, refreshed when bodies sleep or wake
+    std::vector<int> _awakeBodies;
+    std::vector<std::pair<int, int>> _awakeRuns;    // Contiguous [begin, end) ranges of _awakeBodies
+    uint32_t _partitionActivityVersion;
+    
+    // Sleeping: bodies in contact form islands that fall asleep together
+    bool _sleepEnabled;
+    std::vector<int> _islandParent;
+    std::vector<float> _islandTimer;
+    
+    // Cache for temporal coherence: pairs whose Z intervals overlap,
+    // maintained by sweep-and-prune swap events
     std::vector<std::pair<RigidBody*, RigidBody*>> _cachedPairs;
+    std::vector<uint64_t> _cachedPairKeys;               // Parallel to _cachedPairs
+    PairTable _cachedPairIndex;                          // Key -> slot in _cachedPairs
+    
+    // Sweep-and-prune along Z (the long axis of the court)
+    struct Endpoint {
+        float value;
+        int proxy;  // Dense store index (stable until bodies are added or removed)
+        bool isMin;
+    };
+    std::vector<Endpoint> _endpoints;
+    bool _sapDirty;
+    uint32_t _sapLayoutVersion;
+    float _maxSpanZ;                        // Widest dynamic box along Z, for queries on the endpoints
+    bool _queryBoundsCurrent;               // Boxes and broadphase match the positions (refreshBroadPhase)
+    
+    // Broadphase: uniform grid over the court (XZ plane)
+    struct CellRange {
+        int x0, x1;
+        int z0, z1;
+    };
+    std::vector<cocos2d::AABB> _aabbs;      // Per body, parallel to the store's dense arrays
+    std::vector<CellRange> _cellRanges;     // Per body, parallel to the store's dense arrays
+    std::vector<int> _cellStart;            // Prefix offsets into _cellEntries (numCells + 1)
+    std::vector<int> _cellEntries;          // Body indices bucketed by cell
+    std::vector<int> _cellFill;             // Scatter cursor per cell
+    std::vector<int> _unbounded;            // Dynamic bodies too large for the grid
+    std::vector<std::pair<int, int>> _candidates;
+    int _pairTests;
+    
+    static const float GRID_CELL_SIZE;
+    static const int GRID_COLS;
+    static const int GRID_ROWS;
+    
+    bool isPartitionCurrent() const;
+    void updatePartition();
+    void queryStatics();
+    void updateActivity();
+    bool bothAsleep(int i, int j) const;
+    void wakeContacts(const std::vector<Manifold>& manifolds);
+    void updateSleeping(const std::vector<Manifold>& manifolds, float dt);
+    int findIsland(int i);
+    void gridBroadPhase();
+    void sweepAndPrune();
+    void updateEndpoints();
+    void rebuildEndpoints();
+    bool canCollide(RigidBody* a, RigidBody* b) const;
+    void addCachedPair(int a, int b);
+    void removeCachedPair(int a, int b);
+    
+    void buildGrid();
+    int cellX(float x) const;
+    int cellZ(float z) const;
+    bool testPair(int i, int j);
 
     void fixedUpdate(float dt);
-    void applyForces(float dt);
+    void integrate(float dt);
+    void planSubsteps(float dt);
+    bool isBallistic(int i, const cocos2d::AABB& reach, float dt) const;
+    void runSubsteps(float dt);
+    void collideWithStatics(int i);
     void enforceBoundaries();
+    void enforceBoundary(int i);
+    void computeAABBs();
+    void refreshBroadPhase();
+    void sweepFastBodies();
+    bool isFastBody(int i) const;
+    void sweepBody(int i);
+    bool sweepAgainst(int i, int target, const cocos2d::Vec3& start, const cocos2d::Vec3& motion, float& toi);
     void broadPhase(std::vector<std::pair<RigidBody*, RigidBody*>>& pairs);
     void narrowPhase(std::vector<std::pair<RigidBody*, RigidBody*>>& pairs, std::vector<Manifold>& manifolds);
+    void sortByShape(std::vector<std::pair<RigidBody*, RigidBody*>>& pairs);
+    void detectRange(const std::vector<std::pair<RigidBody*, RigidBody*>>& pairs, size_t begin, size_t end,
+                     std::vector<Manifold>& manifolds) const;
+    bool detectPair(RigidBody* a, RigidBody* b, Manifold& m) const;
     void resolveCollisions(const std::vector<Manifold>& manifolds);
+    void applyImpulse(const Contact& c, const cocos2d::Vec3& impulse);
+    void pruneContactCache();
+    void dispatchEvents();
+    void syncNodes();
+    void prepareQueries();
+    void gatherQueryCandidates(const cocos2d::AABB& bounds, int mask);
+    void addQueryCandidate(int j, const cocos2d::AABB& bounds, int mask);
+    bool castCandidates(const Ray& ray, float radius, RaycastHit& hit) const;
+    
+    // Narrowphase dispatch: a detector per ordered pair of collider types.
+    // Mirrored entries reuse the same primitive with the bodies swapped;
+    // null entries are pairs that never meet (static against static).
+    typedef bool (CollisionSystem::*Detector)(RigidBody* a, RigidBody* b, Manifold& m) const;
+    static const Detector DETECTORS[COLLIDER_TYPE_COUNT][COLLIDER_TYPE_COUNT];
+    template <Detector detect>
+    bool detectSwapped(RigidBody* a, RigidBody* b, Manifold& m) const;
     
-    // Detection primitives
-    bool detectSpherePlane(RigidBody* sphere, RigidBody* plane, Manifold& m);
-    bool detectSphereSphere(RigidBody* s1, RigidBody* s2, Manifold& m);
-    bool detectSphereCapsule(RigidBody* sphere, RigidBody* capsule, Manifold& m);
-    bool detectCapsulePlane(RigidBody* capsule, RigidBody* plane, Manifold& m);
+    // Detection primitives. The normal points from the first body to the second.
+    bool detectSpherePlane(RigidBody* sphere, RigidBody* plane, Manifold& m) const;
+    bool detectSphereSphere(RigidBody* s1, RigidBody* s2, Manifold& m) const;
+    bool detectSphereCapsule(RigidBody* sphere, RigidBody* capsule, Manifold& m) const;
+    bool detectCapsuleCapsule(RigidBody* c1, RigidBody* c2, Manifold& m) const;
+    bool detectCapsulePlane(RigidBody* capsule, RigidBody* plane, Manifold& m) const;
+    bool detectSphereBox(RigidBody* sphere, RigidBody* box, Manifold& m) const;
+    bool detectCapsuleBox(RigidBody* capsule, RigidBody* box, Manifold& m) const;
+    bool detectSphereTorus(RigidBody* sphere, RigidBody* torus, Manifold& m) const;
+    bool detectCapsuleTorus(RigidBody* capsule, RigidBody* torus, Manifold& m) const;
 };
 
 #endif // __COLLISION_SYSTEM_H__
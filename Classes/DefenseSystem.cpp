@@ -5,6 +5,8 @@
 #include "SimplePhysics.h"
 #include "ScoreManager.h"
 #include "GameFeedback.h"
+#include "MatchManager.h"
+#include "CollisionSystem.h"
 
 USING_NS_CC;
 
@@ -110,7 +112,7 @@ bool DefenseSystem::checkStealSuccess(Player* target) {
     // Target forward
     // Vec3 targetFwd = ... needs rotation
     
-    return RandomHelper::random_real(0.0f, 1.0f) < chance;
+    return MatchManager::getInstance()->getRandom().defense().nextFloat() < chance;
 }
 
 void DefenseSystem::attemptBlock() {
@@ -129,30 +131,20 @@ void DefenseSystem::attemptBlock() {
         float dist = _owner->getPosition3D().distance(opponent->getPosition3D());
         if (dist < BLOCK_RANGE) {
             // Chance to block
-            // Needs to be in front (Angle check)
-            Vec3 toShooter = opponent->getPosition3D() - _owner->getPosition3D();
-            toShooter.normalize();
-            
-            // Owner's forward vector
-            // We assume owner is facing the shooter if they are defending properly
-            // But let's check the angle between Owner->Shooter and Owner->Forward
-            // Actually, simpler: Check if Owner is "in front" of Shooter.
-            // Shooter is shooting towards Hoop. Owner should be between Shooter and Hoop, or close.
-            // Let's use the dot product of (Shooter->Hoop) and (Shooter->Owner).
-            
+            // Needs to be in front: the first one on the shot's lane from
+            // the shooter to the hoop
             Vec3 hoopPos(0, SimplePhysics::HOOP_HEIGHT, SimplePhysics::HOOP_Z);
             Vec3 shooterToHoop = hoopPos - opponent->getPosition3D();
-            Vec3 shooterToOwner = _owner->getPosition3D() - opponent->getPosition3D();
-            
-            shooterToHoop.y = 0; shooterToOwner.y = 0; // 2D check
-            if (shooterToHoop.length() > 0.1f && shooterToOwner.length() > 0.1f) {
-                shooterToHoop.normalize();
-                shooterToOwner.normalize();
+            shooterToHoop.y = 0; // 2D check
+            CollisionSystem* world = _owner->getWorld();
+            if (world && shooterToHoop.length() > 0.1f) {
+                // The cast starts inside the shooter's capsule, which queries skip
+                CollisionSystem::RaycastHit hit;
+                bool inFront = world->sphereCast(opponent->getPosition3D(), shooterToHoop, BLOCK_LANE_RADIUS,
+                                                 BLOCK_RANGE, hit, SimplePhysics::MASK_PLAYER) &&
+                               hit.body == _owner->getBody();
                 
-                float dot = shooterToHoop.dot(shooterToOwner);
-                // dot > 0.5 means Owner is roughly in the direction of the shot (Front)
-                
-                if (dot > 0.5f) {
+                if (inFront) {
                     // Base Block Chance (Hard Block / Steal)
                     // Drastically reduced to allow "Contested Shots" instead of automatic turnovers
                     float blockChance = 0.0f;
@@ -167,7 +159,7 @@ void DefenseSystem::attemptBlock() {
                     // blockChance += _owner->getBlockStat() * 0.01f;
                     
                     // Random Roll
-                    if (cocos2d::RandomHelper::random_real(0.0f, 1.0f) < blockChance) {
+                    if (MatchManager::getInstance()->getRandom().defense().nextFloat() < blockChance) {
                         // Successful Block!
                         CCLOG("Blocked by %s!", _owner->getName().c_str());
                         
@@ -203,7 +195,7 @@ void DefenseSystem::onOpponentCrossover() {
     if (_isStance) chance -= 0.1f;
     
     // Random check
-    if (cocos2d::RandomHelper::random_real(0.0f, 1.0f) < chance) {
+    if (MatchManager::getInstance()->getRandom().defense().nextFloat() < chance) {
         // Ankle Broken!
         _stunTimer = 1.0f; // Stunned for 1 second
         
@@ -214,3 +206,17 @@ void DefenseSystem::onOpponentCrossover() {
         if (_isStance) exitStance();
     }
 }
+
+void DefenseSystem::snapshot(Snapshot& out) const {
+    out.isStance = _isStance;
+    out.stunTimer = _stunTimer;
+    out.stealCooldown = _stealCooldown;
+    out.blockCooldown = _blockCooldown;
+}
+
+void DefenseSystem::restore(const Snapshot& snapshot) {
+    _isStance = snapshot.isStance;
+    _stunTimer = snapshot.stunTimer;
+    _stealCooldown = snapshot.stealCooldown;
+    _blockCooldown = snapshot.blockCooldown;
+}
@@ -23,6 +23,16 @@ public:
     bool isStance() const { return _isStance; }
     bool isStunned() const { return _stunTimer > 0; }
     bool canSteal() const { return _stealCooldown <= 0; }
+
+    // For Player::Snapshot
+    struct Snapshot {
+        bool isStance;
+        float stunTimer;
+        float stealCooldown;
+        float blockCooldown;
+    };
+    void snapshot(Snapshot& out) const;
+    void restore(const Snapshot& snapshot);
     
 private:
     Player* _owner;
@@ -35,6 +45,7 @@ private:
     // Constants
     const float STEAL_RANGE = 2.0f;
     const float BLOCK_RANGE = 2.5f;
+    const float BLOCK_LANE_RADIUS = 0.4f; // Plus a player's radius: half the lane's width
     const float STANCE_SPEED_MODIFIER = 0.6f;
     
     bool checkStealSuccess(Player* target);
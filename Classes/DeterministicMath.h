@@ -0,0 +1,114 @@
+#ifndef __DETERMINISTIC_MATH_H__
+#define __DETERMINISTIC_MATH_H__
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define DETERMINISTIC_MATH_MXCSR 1
+#else
+#include <cfenv>
+#define DETERMINISTIC_MATH_MXCSR 0
+#endif
+
+// Float math that gives the same bits on every build. libm's sin / cos /
+// atan2 / acos differ between C library versions, so gameplay code uses
+// these instead: plain +, -, *, / and sqrt, which IEEE 754 rounds exactly.
+// That only holds without FMA contraction, which NBA2K_DETERMINISTIC turns
+// off (see CMakeLists.txt). Accurate to about 1e-7.
+namespace DeterministicMath {
+    constexpr float PI = 3.14159265358979f;
+    constexpr float HALF_PI = 1.57079632679490f;
+    constexpr float TWO_PI = 6.28318530717959f;
+
+    // sin on [-pi/2, pi/2], Taylor series to x^11
+    inline float sinReduced(float x) {
+        float x2 = x * x;
+        return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f
+                 + x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+    }
+
+    // To [-pi, pi]. 2pi is split so that k * 6.28125f is exact.
+    inline float reduceAngle(float x) {
+        float k = std::floor(x * (1.0f / TWO_PI) + 0.5f);
+        return (x - k * 6.28125f) - k * 1.93530717958647692e-3f;
+    }
+
+    inline float sin(float x) {
+        x = reduceAngle(x);
+        if (x > HALF_PI) x = PI - x;
+        else if (x < -HALF_PI) x = -PI - x;
+        return sinReduced(x);
+    }
+
+    inline float cos(float x) {
+        return sinReduced(HALF_PI - std::fabs(reduceAngle(x)));
+    }
+
+    // atan on [-tan(pi/12), tan(pi/12)], Taylor series to t^11
+    inline float atanReduced(float t) {
+        float t2 = t * t;
+        return t * (1.0f - t2 * (1.0f / 3.0f - t2 * (1.0f / 5.0f - t2 * (1.0f / 7.0f
+                 - t2 * (1.0f / 9.0f - t2 * (1.0f / 11.0f))))));
+    }
+
+    // Returns 0 for (0, 0)
+    inline float atan2(float y, float x) {
+        float ay = std::fabs(y);
+        float ax = std::fabs(x);
+        if (ax == 0.0f && ay == 0.0f) return 0.0f;
+
+        // First octant: t in [0, 1]
+        bool swapped = ay > ax;
+        float t = swapped ? ax / ay : ay / ax;
+        float offset = 0.0f;
+        if (t > 0.267949192f) {
+            // atan(t) = pi/6 + atan((t*sqrt(3) - 1) / (t + sqrt(3)))
+            t = (t * 1.73205081f - 1.0f) / (t + 1.73205081f);
+            offset = PI / 6.0f;
+        }
+        float angle = offset + atanReduced(t);
+
+        if (swapped) angle = HALF_PI - angle;
+        if (x < 0.0f) angle = PI - angle;
+        return y < 0.0f ? -angle : angle;
+    }
+
+    inline float acos(float x) {
+        if (x > 1.0f) x = 1.0f;
+        if (x < -1.0f) x = -1.0f;
+        return atan2(std::sqrt((1.0f - x) * (1.0f + x)), x);
+    }
+
+    // Holds the float environment every tick assumes: round to nearest,
+    // denormals kept (no flush-to-zero), exceptions masked. Graphics drivers
+    // and audio libraries may leave the main thread in another mode, which
+    // would make the game's ticks differ from the headless build's.
+    class FloatModeScope {
+    public:
+        FloatModeScope() {
+#if DETERMINISTIC_MATH_MXCSR
+            _saved = _mm_getcsr();
+            // Clear rounding (bits 13-14), FTZ (15) and DAZ (6); mask all exceptions
+            _mm_setcsr((_saved & ~0xE040u) | 0x1F80u);
+#else
+            _saved = (unsigned int)std::fegetround();
+            std::fesetround(FE_TONEAREST);
+#endif
+        }
+        ~FloatModeScope() {
+#if DETERMINISTIC_MATH_MXCSR
+            _mm_setcsr(_saved);
+#else
+            std::fesetround((int)_saved);
+#endif
+        }
+        FloatModeScope(const FloatModeScope&) = delete;
+        FloatModeScope& operator=(const FloatModeScope&) = delete;
+
+    private:
+        unsigned int _saved;
+    };
+}
+
+#endif // __DETERMINISTIC_MATH_H__
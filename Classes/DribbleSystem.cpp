@@ -4,6 +4,7 @@
 #include "SimplePhysics.h"
 #include "AudioManager.h"
 #include "SoundBank.h"
+#include "MatchManager.h"
 
 USING_NS_CC;
 
@@ -173,11 +174,32 @@ void DribbleSystem::loseBall(const Vec3& forceDirection) {
         vel.y += 3.0f; // Pop up
         
         // Add random horizontal noise to prevent perfect vertical bouncing
-        float noiseX = cocos2d::RandomHelper::random_real(-1.0f, 1.0f);
-        float noiseZ = cocos2d::RandomHelper::random_real(-1.0f, 1.0f);
+        RandomStream& random = MatchManager::getInstance()->getRandom().defense();
+        float noiseX = random.range(-1.0f, 1.0f);
+        float noiseZ = random.range(-1.0f, 1.0f);
         vel.x += noiseX;
         vel.z += noiseZ;
         
         ball->setVelocity(vel);
     }
 }
+
+void DribbleSystem::snapshot(Snapshot& out) const {
+    out.isDribbling = _isDribbling;
+    out.crossoverCooldown = _crossoverCooldown;
+    out.dribbleTimer = _dribbleTimer;
+    out.dribbleInterval = _dribbleInterval;
+    out.isMovingDown = _isMovingDown;
+    out.handOffset = _handOffset;
+    out.targetHandPos = _targetHandPos;
+}
+
+void DribbleSystem::restore(const Snapshot& snapshot) {
+    _isDribbling = snapshot.isDribbling;
+    _crossoverCooldown = snapshot.crossoverCooldown;
+    _dribbleTimer = snapshot.dribbleTimer;
+    _dribbleInterval = snapshot.dribbleInterval;
+    _isMovingDown = snapshot.isMovingDown;
+    _handOffset = snapshot.handOffset;
+    _targetHandPos = snapshot.targetHandPos;
+}
@@ -22,6 +22,19 @@ public:
     bool isDribbling() const { return _isDribbling; }
     void onMovement(const cocos2d::Vec3& velocity);
     const cocos2d::Vec3& getHandOffset() const { return _handOffset; }
+
+    // For Player::Snapshot
+    struct Snapshot {
+        bool isDribbling;
+        float crossoverCooldown;
+        float dribbleTimer;
+        float dribbleInterval;
+        bool isMovingDown;
+        cocos2d::Vec3 handOffset;
+        cocos2d::Vec3 targetHandPos;
+    };
+    void snapshot(Snapshot& out) const;
+    void restore(const Snapshot& snapshot);
     
 private:
     Player* _owner;
@@ -1,4 +1,5 @@
 #include "EffectsManager.h"
+#include "MatchManager.h"
 
 USING_NS_CC;
 
@@ -131,9 +132,10 @@ void EffectsManager::update(float dt) {
             if (camera) {
                 if (_originalCameraPos.isZero()) _originalCameraPos = camera->getPosition3D();
                 
-                float offsetX = (CCRANDOM_0_1() * 2 - 1) * _shakeIntensity;
-                float offsetY = (CCRANDOM_0_1() * 2 - 1) * _shakeIntensity;
-                float offsetZ = (CCRANDOM_0_1() * 2 - 1) * _shakeIntensity;
+                RandomStream& random = MatchManager::getInstance()->getRandom().cosmetic();
+                float offsetX = random.range(-1.0f, 1.0f) * _shakeIntensity;
+                float offsetY = random.range(-1.0f, 1.0f) * _shakeIntensity;
+                float offsetZ = random.range(-1.0f, 1.0f) * _shakeIntensity;
                 
                 camera->setPosition3D(_originalCameraPos + Vec3(offsetX, offsetY, offsetZ));
             }
@@ -2,7 +2,7 @@
 
 USING_NS_CC;
 
-GameFlow* GameFlow::_instance = nullptr;
+thread_local GameFlow* GameFlow::_instance = nullptr;
 
 GameFlow* GameFlow::getInstance() {
     if (!_instance) {
@@ -20,6 +20,8 @@ public:
     
     void changeState(State newState);
     State getState() const { return _currentState; }
+    // Sets the state without firing onStateChanged, for replay keyframes
+    void restoreState(State state) { _currentState = state; }
 
     bool isPlaying() const { return _currentState == State::PLAYING; }
     bool isPaused() const { return _currentState == State::PAUSED; }
@@ -31,7 +33,7 @@ private:
     GameFlow();
     ~GameFlow();
 
-    static GameFlow* _instance;
+    static thread_local GameFlow* _instance; // One per thread, like MatchManager
     State _currentState;
 };
 
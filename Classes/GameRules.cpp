@@ -156,6 +156,7 @@ void GameRules::checkShotClock() {
         _lastViolation = Violation::SHOT_CLOCK;
         
         bool isPlayerViolation = (_currentOffense == _player);
+        MatchManager::getInstance()->recordShotClockViolation(isPlayerViolation);
         MatchManager::getInstance()->handleViolation(isPlayerViolation, "SHOT CLOCK");
     }
 }
@@ -218,6 +219,7 @@ void GameRules::onBallHitRim() {
 
 void GameRules::onPossessionChange(Player* newOwner) {
     if (_currentOffense != newOwner) {
+        MatchManager::getInstance()->recordPossession(newOwner == _player);
         ScoreManager::getInstance()->resetShotClock();
         _lastViolation = Violation::NONE; // Clear violation on possession change
         
@@ -271,4 +273,22 @@ int GameRules::calculateShotPoints(const Vec3& shootPos) {
     
     if (dist > THREE_POINT_DIST) return 3;
     return 2;
-}
\ No newline at end of file
+}
+
+void GameRules::snapshot(Snapshot& out) const {
+    out.currentOffense = _currentOffense;
+    out.lastViolation = _lastViolation;
+    out.possessionTimer = _possessionTimer;
+    out.prevBallPos = _prevBallPos;
+    out.shotPos = _shotPos;
+    out.needsToClearBall = _needsToClearBall;
+}
+
+void GameRules::restore(const Snapshot& snapshot) {
+    _currentOffense = snapshot.currentOffense;
+    _lastViolation = snapshot.lastViolation;
+    _possessionTimer = snapshot.possessionTimer;
+    _prevBallPos = snapshot.prevBallPos;
+    _shotPos = snapshot.shotPos;
+    _needsToClearBall = snapshot.needsToClearBall;
+}
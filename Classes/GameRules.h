@@ -33,6 +33,18 @@ public:
     
     // Clear Ball Rule
     bool needsToClearBall() const { return _needsToClearBall; }
+
+    // For replay keyframes
+    struct Snapshot {
+        Player* currentOffense;
+        Violation lastViolation;
+        float possessionTimer;
+        cocos2d::Vec3 prevBallPos;
+        cocos2d::Vec3 shotPos;
+        bool needsToClearBall;
+    };
+    void snapshot(Snapshot& out) const;
+    void restore(const Snapshot& snapshot);
     
 private:
     Player* _player;
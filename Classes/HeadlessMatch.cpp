@@ -0,0 +1,292 @@
+#include "HeadlessMatch.h"
+#include "Player.h"
+#include "Basketball.h"
+#include "Hoop.h"
+#include "AIController.h"
+#include "RecordingController.h"
+#include "GameRules.h"
+#include "ScoreManager.h"
+#include "MatchManager.h"
+#include "GameFlow.h"
+#include "SimplePhysics.h"
+#include "RigidBody.h"
+#include "AudioManager.h"
+#include "EffectsManager.h"
+#include "GameFeedback.h"
+#include "DeterministicMath.h"
+#include <mutex>
+#include <cfloat>
+
+USING_NS_CC;
+
+// Creating and destroying nodes goes through engine globals that aren't
+// thread-safe (the Director's scheduler and the autorelease pool), so
+// matches on different threads take turns setting up and tearing down.
+// Stepping only touches the match's own objects.
+static std::mutex s_sceneGraphMutex;
+
+void HeadlessMatch::initSharedState() {
+    Director::getInstance();
+    AudioManager::getInstance();
+    EffectsManager::getInstance();
+    GameFeedback::getInstance();
+}
+
+HeadlessMatch::HeadlessMatch(const Config& config)
+    : _config(config)
+    , _root(nullptr)
+    , _home(nullptr)
+    , _away(nullptr)
+    , _ball(nullptr)
+    , _homeController(nullptr)
+    , _awayController(nullptr)
+    , _rules(nullptr)
+    , _tickHash(0)
+    , _recordLog(nullptr)
+    , _homeRecorder(nullptr)
+    , _awayRecorder(nullptr)
+    , _replayLog(nullptr)
+    , _homeReplay(nullptr)
+    , _awayReplay(nullptr)
+{
+    _result.homeScore = 0;
+    _result.awayScore = 0;
+    _result.homePossessions = 0;
+    _result.awayPossessions = 0;
+    _result.homeShotClockViolations = 0;
+    _result.awayShotClockViolations = 0;
+    _result.gameSeconds = 0.0f;
+    _result.ticks = 0;
+    _result.finished = false;
+    _result.stateHash = 0;
+
+    std::lock_guard<std::mutex> lock(s_sceneGraphMutex);
+
+    GameFlow::getInstance()->reset();
+    MatchManager::getInstance()->seedRandom(_config.seed);
+
+    _root = new (std::nothrow) Node();
+    _root->init();
+
+    createCourt();
+    createPlayers();
+    createBall();
+
+    // Init Rules & Match (as BasketballScene::init)
+    _rules = new GameRules(_home, _away, _ball);
+    MatchManager::getInstance()->init(_home, _away, _ball);
+    MatchManager::getInstance()->startMatch();
+
+    // Nodes are kept alive by _root. Without the Director's main loop nothing
+    // drains the autorelease pool, so do it here.
+    PoolManager::getInstance()->getCurrentPool()->clear();
+}
+
+HeadlessMatch::~HeadlessMatch() {
+    std::lock_guard<std::mutex> lock(s_sceneGraphMutex);
+
+    // Drop the game-flow singletons' pointers before the nodes go away
+    MatchManager::getInstance()->init(nullptr, nullptr, nullptr);
+
+    _root->cleanup();
+    _root->release();
+
+    delete _rules;
+    delete _homeController;
+    delete _awayController;
+    delete _homeRecorder;
+    delete _awayRecorder;
+    delete _homeReplay;
+    delete _awayReplay;
+
+    for (auto body : _courtBodies) {
+        _world.removeBody(body);
+        delete body;
+    }
+    _courtBodies.clear();
+}
+
+void HeadlessMatch::createCourt() {
+    // Floor
+    auto floor = new RigidBody(ColliderType::PLANE, SimplePhysics::MASK_FLOOR, SimplePhysics::MASK_PLAYER | SimplePhysics::MASK_BALL);
+    floor->setPlane(Vec3::UNIT_Y, 0.0f);
+    _world.addBody(floor);
+    _courtBodies.push_back(floor);
+
+    // Hoop post
+    auto post = new RigidBody(ColliderType::CAPSULE, SimplePhysics::MASK_HOOP, SimplePhysics::MASK_PLAYER | SimplePhysics::MASK_BALL);
+    post->setCapsule(0.2f, SimplePhysics::HOOP_HEIGHT);
+    post->setPosition(Vec3(0, SimplePhysics::HOOP_HEIGHT / 2, SimplePhysics::HOOP_Z - 0.8f));
+    post->setStatic(true);
+    _world.addBody(post);
+    _courtBodies.push_back(post);
+
+    // Board and rim
+    auto hoop = Hoop::create(&_world);
+    if (hoop) {
+        hoop->setPosition3D(Vec3(0, SimplePhysics::HOOP_HEIGHT, SimplePhysics::HOOP_Z));
+        _root->addChild(hoop);
+    }
+}
+
+void HeadlessMatch::createPlayers() {
+    _home = Player::create(&_world);
+    _home->setPosition3D(Vec3(0, 1.0f, 10.0f));
+    _home->setRotation3D(Vec3(0, 180.0f, 0));
+    _home->setStats(_config.home.speed, _config.home.shooting, _config.home.defense);
+    _home->onShoot = [this](Player* p) {
+        if (_rules) _rules->onBallShot(p);
+    };
+    _root->addChild(_home);
+
+    _away = Player::create(&_world);
+    _away->setPosition3D(Vec3(0, 1.0f, 0.0f));
+    _away->setRotation3D(Vec3(0, 0, 0));
+    _away->setStats(_config.away.speed, _config.away.shooting, _config.away.defense);
+    _away->onShoot = [this](Player* p) {
+        if (_rules) _rules->onBallShot(p);
+    };
+    _root->addChild(_away);
+
+    _home->setOpponent(_away);
+    _away->setOpponent(_home);
+}
+
+void HeadlessMatch::createBall() {
+    _ball = Basketball::create(&_world);
+    _ball->setPosition3D(Vec3(2.0f, 5.0f, 10.0f));
+    _root->addChild(_ball);
+
+    // Home starts with the ball
+    _home->setBall(_ball);
+    _home->setPossession(true);
+    _ball->setOwner(_home);
+    _ball->setState(Basketball::State::HELD);
+
+    _away->setBall(_ball);
+    _away->setPossession(false);
+
+    // Both sides are driven by the AI
+    _homeController = new AIController(_away, _ball, _config.home.difficulty);
+    _home->setController(_homeController);
+
+    _awayController = new AIController(_home, _ball, _config.away.difficulty);
+    _away->setController(_awayController);
+}
+
+HeadlessMatch::Config HeadlessMatch::Config::forReplay(const InputLog& log) {
+    Config config;
+    const InputLog::Lineup& home = log.getLineup(InputLog::HOME);
+    const InputLog::Lineup& away = log.getLineup(InputLog::AWAY);
+    config.home = Side(AIBrain::Difficulty::NORMAL, home.speed, home.shooting, home.defense);
+    config.away = Side(AIBrain::Difficulty::NORMAL, away.speed, away.shooting, away.defense);
+    config.seed = log.getSeed();
+    config.maxSeconds = FLT_MAX; // The log says when to stop
+    return config;
+}
+
+void HeadlessMatch::startRecording(InputLog* log) {
+    _recordLog = log;
+    _recordLog->clear();
+    _recordLog->setSeed(_config.seed);
+    _recordLog->setLineup(InputLog::HOME, InputLog::Lineup(_config.home.speed, _config.home.shooting, _config.home.defense));
+    _recordLog->setLineup(InputLog::AWAY, InputLog::Lineup(_config.away.speed, _config.away.shooting, _config.away.defense));
+
+    _homeRecorder = new RecordingController(_homeController, _recordLog, InputLog::HOME);
+    _home->setController(_homeRecorder);
+    _awayRecorder = new RecordingController(_awayController, _recordLog, InputLog::AWAY);
+    _away->setController(_awayRecorder);
+}
+
+void HeadlessMatch::startReplay(const InputLog* log) {
+    _replayLog = log;
+
+    _homeReplay = new ReplayController(_replayLog, InputLog::HOME);
+    _home->setController(_homeReplay);
+    _awayReplay = new ReplayController(_replayLog, InputLog::AWAY);
+    _away->setController(_awayReplay);
+}
+
+void HeadlessMatch::saveKeyframe(Keyframe& out) const {
+    CCASSERT(_replayLog, "Keyframes are for replays");
+    _world.snapshot(out.world);
+    MatchManager::getInstance()->snapshot(out.match);
+    _rules->snapshot(out.rules);
+    _homeReplay->snapshot(out.home);
+    _awayReplay->snapshot(out.away);
+    out.result = _result;
+    out.tickHash = _tickHash;
+}
+
+bool HeadlessMatch::loadKeyframe(const Keyframe& keyframe) {
+    CCASSERT(_replayLog, "Keyframes are for replays");
+
+    // Gameplay first: restoring the ball's state wakes its body, and the
+    // world's snapshot then puts back whether it was asleep
+    MatchManager::getInstance()->restore(keyframe.match);
+    _rules->restore(keyframe.rules);
+    _homeReplay->restore(keyframe.home);
+    _awayReplay->restore(keyframe.away);
+    if (!_world.restore(keyframe.world)) return false;
+
+    _result = keyframe.result;
+    _tickHash = keyframe.tickHash;
+    return true;
+}
+
+bool HeadlessMatch::step() {
+    if (_result.finished || _result.gameSeconds >= _config.maxSeconds) return false;
+    if (_replayLog && (uint32_t)_result.ticks >= _replayLog->getTickCount()) return false;
+
+    const float dt = SimplePhysics::FIXED_TIME_STEP;
+    DeterministicMath::FloatModeScope floatMode;
+
+    // Same order as a frame of the game: scheduled node updates first
+    // (in the order they were created), then BasketballScene::update
+    _home->update(dt);
+    _away->update(dt);
+    _ball->update(dt);
+
+    GameFlow::getInstance()->update(dt);
+    MatchManager::getInstance()->update(dt);
+    _world.update(dt);
+    _rules->update(dt);
+
+    _result.ticks++;
+    _result.gameSeconds += dt;
+    _result.homeScore = ScoreManager::getInstance()->getPlayerScore();
+    _result.awayScore = ScoreManager::getInstance()->getAIScore();
+    
+    const PlayerStats& home = MatchManager::getInstance()->getPlayerStats();
+    const PlayerStats& away = MatchManager::getInstance()->getAIStats();
+    _result.homePossessions = home.possessions;
+    _result.awayPossessions = away.possessions;
+    _result.homeShotClockViolations = home.shotClockViolations;
+    _result.awayShotClockViolations = away.shotClockViolations;
+    _result.finished = (GameFlow::getInstance()->getState() == GameFlow::State::FINISHED);
+
+    StateHash tick;
+    hashState(tick);
+    _tickHash = tick.get();
+    StateHash chain;
+    chain.addU64(_result.stateHash);
+    chain.addU64(_tickHash);
+    _result.stateHash = chain.get();
+
+    if (_recordLog && _result.ticks % InputLog::CHECKPOINT_INTERVAL == 0) {
+        _recordLog->addCheckpoint((uint32_t)_result.ticks, _tickHash);
+    }
+
+    if (_replayLog && (uint32_t)_result.ticks >= _replayLog->getTickCount()) return false;
+    return !_result.finished && _result.gameSeconds < _config.maxSeconds;
+}
+
+void HeadlessMatch::hashState(StateHash& hash) const {
+    _world.hashState(hash);
+    MatchManager::getInstance()->hashState(hash);
+}
+
+const HeadlessMatch::Result& HeadlessMatch::run() {
+    while (step()) {}
+    return _result;
+}
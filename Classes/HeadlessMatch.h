@@ -0,0 +1,143 @@
+#ifndef __HEADLESS_MATCH_H__
+#define __HEADLESS_MATCH_H__
+
+#include "cocos2d.h"
+#include "AIBrain.h"
+#include "CollisionSystem.h"
+#include "MatchManager.h"
+#include "GameRules.h"
+#include "InputLog.h"
+#include "ReplayController.h"
+#include "StateHash.h"
+#include <vector>
+#include <cstdint>
+
+class Player;
+class Basketball;
+class AIController;
+class RecordingController;
+class RigidBody;
+
+// One AI-vs-AI match without a scene, GL view, audio or assets, stepped at
+// the fixed physics rate as fast as the CPU allows. Built into the nba2k_sim
+// target (NBA2K_HEADLESS=1), where the game objects skip their visuals.
+//
+// The match owns its physics world; ScoreManager, MatchManager and GameFlow
+// are per thread, so one match may run on each thread. Call
+// initSharedState() on the main thread before starting matches on others.
+class HeadlessMatch {
+public:
+    struct Side {
+        AIBrain::Difficulty difficulty;
+        float speed;
+        float shooting;
+        float defense;
+
+        Side(AIBrain::Difficulty difficulty = AIBrain::Difficulty::NORMAL,
+             float speed = 50.0f, float shooting = 50.0f, float defense = 50.0f)
+            : difficulty(difficulty), speed(speed), shooting(shooting), defense(defense) {}
+    };
+
+    struct Config {
+        Side home;          // Scored as "Player", starts with the ball
+        Side away;          // Scored as "AI"
+        float maxSeconds;   // Give up on a match that hasn't ended by then
+        uint64_t seed;      // Seeds the match's RNG streams; same seed, same match
+
+        // Same line-up as BasketballScene (the AI side is slowed down)
+        Config() : home(), away(AIBrain::Difficulty::NORMAL, 35.0f), maxSeconds(600.0f), seed(0) {}
+
+        // The seed and line-up 'log' was recorded with
+        static Config forReplay(const InputLog& log);
+    };
+
+    struct Result {
+        int homeScore;
+        int awayScore;
+        int homePossessions;
+        int awayPossessions;
+        int homeShotClockViolations;
+        int awayShotClockViolations;
+        float gameSeconds;  // Simulated time
+        int ticks;
+        bool finished;      // False if maxSeconds ran out first
+        uint64_t stateHash; // Every tick's state hash, chained: equal only if every tick matched
+
+        // 1 home win, -1 away win, 0 draw
+        int winner() const { return homeScore > awayScore ? 1 : (awayScore > homeScore ? -1 : 0); }
+    };
+
+    // Creates the singletons that every thread's matches share
+    static void initSharedState();
+
+    explicit HeadlessMatch(const Config& config = Config());
+    ~HeadlessMatch();
+    HeadlessMatch(const HeadlessMatch&) = delete;
+    HeadlessMatch& operator=(const HeadlessMatch&) = delete;
+
+    // Advances one fixed step; returns false once the match is over
+    bool step();
+    // Steps until the match is over
+    const Result& run();
+
+    const Result& getResult() const { return _result; }
+    CollisionSystem& getWorld() { return _world; }
+
+    // Hash of the state after the last step: the world plus
+    // MatchManager::hashState. Two runs with the same seed and input (on any
+    // NBA2K_DETERMINISTIC build) agree on it at every tick.
+    uint64_t getTickHash() const { return _tickHash; }
+
+    // Call before the first step. Records both sides' input into 'log' (with
+    // a checkpoint hash every InputLog::CHECKPOINT_INTERVAL ticks); the log
+    // must outlive the match.
+    void startRecording(InputLog* log);
+    // Call before the first step, on a match built from Config::forReplay.
+    // Plays 'log' instead of running the AI, and ends where the log does.
+    void startReplay(const InputLog* log);
+    bool isReplaying() const { return _replayLog != nullptr; }
+
+    // Everything a replay needs to carry on from the current tick. In
+    // memory only: it points at this match's objects. See MatchReplay.
+    struct Keyframe {
+        CollisionSystem::Snapshot world;
+        MatchManager::Snapshot match;
+        GameRules::Snapshot rules;
+        ReplayController::Snapshot home;
+        ReplayController::Snapshot away;
+        Result result;
+        uint64_t tickHash;
+    };
+    // Replays only (the AI's own state isn't captured)
+    void saveKeyframe(Keyframe& out) const;
+    bool loadKeyframe(const Keyframe& keyframe);
+
+private:
+    Config _config;
+    Result _result;
+
+    CollisionSystem _world;
+    cocos2d::Node* _root;       // Parent of every game node, stands in for the scene
+    Player* _home;
+    Player* _away;
+    Basketball* _ball;
+    AIController* _homeController;
+    AIController* _awayController;
+    GameRules* _rules;
+    std::vector<RigidBody*> _courtBodies;
+    uint64_t _tickHash;
+
+    InputLog* _recordLog;
+    RecordingController* _homeRecorder;
+    RecordingController* _awayRecorder;
+    const InputLog* _replayLog;
+    ReplayController* _homeReplay;
+    ReplayController* _awayReplay;
+
+    void createCourt();
+    void createPlayers();
+    void createBall();
+    void hashState(StateHash& hash) const;
+};
+
+#endif // __HEADLESS_MATCH_H__
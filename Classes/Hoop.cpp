@@ -7,8 +7,12 @@
 USING_NS_CC;
 
 Hoop* Hoop::create() {
+    return create(CollisionSystem::getInstance());
+}
+
+Hoop* Hoop::create(CollisionSystem* world) {
     Hoop* ret = new (std::nothrow) Hoop();
-    if (ret && ret->init()) {
+    if (ret && ret->init(world)) {
         ret->autorelease();
         return ret;
     }
@@ -18,18 +22,26 @@ Hoop* Hoop::create() {
 
 Hoop::~Hoop() {
     for (auto body : _physicsBodies) {
-        CollisionSystem::getInstance()->removeBody(body);
+        _world->removeBody(body);
         delete body;
     }
     _physicsBodies.clear();
 }
 
 bool Hoop::init() {
+    return init(CollisionSystem::getInstance());
+}
+
+bool Hoop::init(CollisionSystem* world) {
     if (!Node::init()) return false;
     
+    _world = world;
+    
+#if !NBA2K_HEADLESS
     createBackboard();
     createRim();
     createNet();
+#endif
     
     initPhysics();
     
@@ -163,69 +175,35 @@ void Hoop::createNet() {
 }
 
 void Hoop::initPhysics() {
-    // 1. Rim Physics (8 spheres)
-    int segments = 8;
+    // 1. Rim Physics (one torus, so contacts follow the ring smoothly)
     float radius = 0.35f;
-    float sphereRadius = 0.05f; // Thin collider
+    float tubeRadius = 0.05f; // A little thicker than the visual tube
     
-    for (int i = 0; i < segments; ++i) {
-        float angle = i * (2 * M_PI / segments);
-        float x = cos(angle) * radius;
-        float z = sin(angle) * radius;
-        
-        auto body = new RigidBody(ColliderType::SPHERE, SimplePhysics::MASK_HOOP, SimplePhysics::MASK_BALL);
-        body->setSphere(sphereRadius);
-        body->setMass(0.0f); // Static
-        body->setStatic(true);
-        body->setMaterial(SimplePhysicsMaterial(0.5f, 0.5f));
-        
-        // Position is relative to World in Physics Engine!
-        // We need to update this if Hoop moves (it doesn't).
-        // Hoop is at (0, HOOP_HEIGHT, HOOP_Z).
-        
-        Vec3 worldPos = Vec3(0, SimplePhysics::HOOP_HEIGHT, SimplePhysics::HOOP_Z) + Vec3(x, 0, z);
-        body->setPosition(worldPos);
-        
-        CollisionSystem::getInstance()->addBody(body);
-        _physicsBodies.push_back(body);
-    }
+    auto rim = new RigidBody(ColliderType::TORUS, SimplePhysics::MASK_HOOP, SimplePhysics::MASK_BALL);
+    rim->setTorus(radius, tubeRadius);
+    rim->setMass(0.0f); // Static
+    rim->setStatic(true);
+    rim->setMaterial(SimplePhysicsMaterial(0.5f, 0.5f));
+    
+    // Position is relative to World in Physics Engine!
+    // We need to update this if Hoop moves (it doesn't).
+    rim->setPosition(Vec3(0, SimplePhysics::HOOP_HEIGHT, SimplePhysics::HOOP_Z));
     
-    // 2. Backboard Physics (Approximation with spheres)
+    _world->addBody(rim);
+    _physicsBodies.push_back(rim);
+    
+    // 2. Backboard Physics (one oriented box matching the visual board)
     // Board is at Z = HOOP_Z - 0.5f
-    // Size 1.8 x 1.05
-    // Grid of spheres
     
     float boardZ = SimplePhysics::HOOP_Z - 0.5f;
     float boardY = SimplePhysics::HOOP_HEIGHT + 0.3f;
     
-    int cols = 3;
-    int rows = 2;
-    float colSpacing = 0.5f;
-    float rowSpacing = 0.4f;
-    float colliderRadius = 0.3f;
+    auto board = new RigidBody(ColliderType::BOX, SimplePhysics::MASK_HOOP, SimplePhysics::MASK_BALL);
+    board->setBox(Vec3(BACKBOARD_WIDTH / 2, BACKBOARD_HEIGHT / 2, BACKBOARD_THICKNESS / 2));
+    board->setStatic(true);
+    board->setMaterial(SimplePhysicsMaterial(0.3f, 0.5f)); // Less bounce
+    board->setPosition(Vec3(0, boardY, boardZ));
     
-    for (int c = -1; c <= 1; ++c) {
-        for (int r = -1; r <= 1; ++r) {
-            if (r == 0) continue; // Skip center row to reduce count? No.
-            
-            float x = c * colSpacing;
-            float y = boardY + r * rowSpacing; // Relative to board center
-            
-            auto body = new RigidBody(ColliderType::SPHERE, SimplePhysics::MASK_HOOP, SimplePhysics::MASK_BALL);
-            body->setSphere(colliderRadius);
-            body->setStatic(true);
-            body->setMaterial(SimplePhysicsMaterial(0.3f, 0.5f)); // Less bounce
-            
-            // Offset Z slightly to align front of sphere with board face
-            // Board face is at boardZ + thickness/2.
-            // Sphere surface should be there.
-            // Center = FaceZ - Radius
-            float z = boardZ - colliderRadius + 0.05f; 
-            
-            body->setPosition(Vec3(x, y, z));
-            
-            CollisionSystem::getInstance()->addBody(body);
-            _physicsBodies.push_back(body);
-        }
-    }
+    _world->addBody(board);
+    _physicsBodies.push_back(board);
 }
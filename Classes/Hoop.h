@@ -5,17 +5,21 @@
 #include <vector>
 
 class RigidBody;
+class CollisionSystem;
 
 class Hoop : public cocos2d::Node {
 public:
     static Hoop* create();
+    static Hoop* create(CollisionSystem* world);
     virtual bool init() override;
+    bool init(CollisionSystem* world);
     virtual ~Hoop();
     
     // Physics
     void initPhysics();
     
 private:
+    CollisionSystem* _world = nullptr;
     std::vector<RigidBody*> _physicsBodies;
     
     void createBackboard();
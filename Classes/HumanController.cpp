@@ -1,5 +1,6 @@
 #include "HumanController.h"
 #include "Player.h" // To check state/position
+#include "DeterministicMath.h"
 
 USING_NS_CC;
 
@@ -28,8 +29,10 @@ Vec2 HumanController::getMoveInput() {
         
         // Rotate input by camera angle so UP is always "forward" relative to camera
         float rad = CC_DEGREES_TO_RADIANS(_cameraAngleY);
-        float x = targetInput.x * cos(rad) - targetInput.y * sin(rad);
-        float y = targetInput.x * sin(rad) + targetInput.y * cos(rad);
+        float c = DeterministicMath::cos(rad);
+        float s = DeterministicMath::sin(rad);
+        float x = targetInput.x * c - targetInput.y * s;
+        float y = targetInput.x * s + targetInput.y * c;
         targetInput.x = x;
         targetInput.y = y;
     }
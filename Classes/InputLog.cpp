@@ -0,0 +1,295 @@
+#include "InputLog.h"
+#include "PlayerController.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+static const char MAGIC[4] = { 'N', 'B', 'R', 'P' };
+static const uint8_t VERSION = 1;
+
+// Run header byte: bits 0-2 say which fields follow, bits 3-7 hold the run
+// length - 1, or 31 with the rest of the length in a varint after it
+static const uint8_t RUN_MOVE_X = 1 << 0;
+static const uint8_t RUN_MOVE_Y = 1 << 1;
+static const uint8_t RUN_BUTTONS = 1 << 2;
+static const uint32_t RUN_LENGTH_INLINE = 31;
+
+static int8_t quantizeAxis(float value) {
+    float q = std::floor(value * 127.0f + 0.5f);
+    if (q > 127.0f) q = 127.0f;
+    if (q < -127.0f) q = -127.0f;
+    return (int8_t)q;
+}
+
+InputFrame InputFrame::capture(PlayerController* controller) {
+    InputFrame frame;
+    cocos2d::Vec2 move = controller->getMoveInput();
+    frame.moveX = quantizeAxis(move.x);
+    frame.moveY = quantizeAxis(move.y);
+    if (controller->isSprintPressed()) frame.buttons |= SPRINT;
+    if (controller->isJumpPressed()) frame.buttons |= JUMP;
+    if (controller->isShootPressed()) frame.buttons |= SHOOT;
+    if (controller->isPassPressed()) frame.buttons |= PASS;
+    if (controller->isStealPressed()) frame.buttons |= STEAL;
+    if (controller->isCrossoverPressed()) frame.buttons |= CROSSOVER;
+    if (controller->isDefendPressed()) frame.buttons |= DEFEND;
+    return frame;
+}
+
+// Byte helpers for serialize() / deserialize()
+static void putU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(value >> (8 * i)));
+}
+
+static void putU64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out.push_back((uint8_t)(value >> (8 * i)));
+}
+
+static void putFloat(std::vector<uint8_t>& out, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putU32(out, bits);
+}
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+static bool getVarint(const std::vector<uint8_t>& in, size_t& offset, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (offset >= in.size()) return false;
+        uint8_t byte = in[offset++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+namespace {
+    // Bounds-checked reads; once one fails, every later one does
+    struct Reader {
+        const std::vector<uint8_t>& data;
+        size_t offset;
+        bool ok;
+
+        explicit Reader(const std::vector<uint8_t>& data) : data(data), offset(0), ok(true) {}
+
+        bool take(size_t count) {
+            ok = ok && data.size() - offset >= count;
+            return ok;
+        }
+        uint8_t u8() {
+            return take(1) ? data[offset++] : 0;
+        }
+        uint32_t u32() {
+            if (!take(4)) return 0;
+            uint32_t value = 0;
+            for (int i = 0; i < 4; i++) value |= (uint32_t)data[offset++] << (8 * i);
+            return value;
+        }
+        uint64_t u64() {
+            uint64_t low = u32();
+            return low | ((uint64_t)u32() << 32);
+        }
+        float f32() {
+            uint32_t bits = u32();
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    };
+}
+
+InputLog::InputLog() {
+    clear();
+}
+
+void InputLog::clear() {
+    _seed = 0;
+    for (int i = 0; i < SIDE_COUNT; i++) {
+        _lineups[i] = Lineup();
+        _channels[i] = Channel();
+    }
+    _checkpoints.clear();
+}
+
+void InputLog::append(Side side, const InputFrame& frame) {
+    Channel& channel = _channels[side];
+    if (channel.openLength > 0 && frame != channel.open) {
+        writeRun(channel);
+    }
+    channel.open = frame;
+    channel.openLength++;
+    channel.frames++;
+}
+
+void InputLog::addCheckpoint(uint32_t tick, uint64_t hash) {
+    Checkpoint checkpoint;
+    checkpoint.tick = tick;
+    checkpoint.hash = hash;
+    _checkpoints.push_back(checkpoint);
+}
+
+void InputLog::finish() {
+    for (int i = 0; i < SIDE_COUNT; i++) {
+        if (_channels[i].openLength > 0) writeRun(_channels[i]);
+    }
+}
+
+void InputLog::writeRun(Channel& channel) {
+    const InputFrame& frame = channel.open;
+    uint8_t header = 0;
+    if (frame.moveX != channel.last.moveX) header |= RUN_MOVE_X;
+    if (frame.moveY != channel.last.moveY) header |= RUN_MOVE_Y;
+    if (frame.buttons != channel.last.buttons) header |= RUN_BUTTONS;
+
+    uint32_t length = channel.openLength - 1;
+    uint32_t inlineLength = length < RUN_LENGTH_INLINE ? length : RUN_LENGTH_INLINE;
+    channel.bytes.push_back(header | (uint8_t)(inlineLength << 3));
+    if (inlineLength == RUN_LENGTH_INLINE) putVarint(channel.bytes, length - RUN_LENGTH_INLINE);
+
+    if (header & RUN_MOVE_X) channel.bytes.push_back((uint8_t)frame.moveX);
+    if (header & RUN_MOVE_Y) channel.bytes.push_back((uint8_t)frame.moveY);
+    if (header & RUN_BUTTONS) channel.bytes.push_back(frame.buttons);
+
+    channel.last = frame;
+    channel.openLength = 0;
+}
+
+uint32_t InputLog::getTickCount() const {
+    uint32_t ticks = _channels[0].frames;
+    for (int i = 1; i < SIDE_COUNT; i++) {
+        if (_channels[i].frames < ticks) ticks = _channels[i].frames;
+    }
+    return ticks;
+}
+
+bool InputLog::read(Side side, Cursor& cursor, InputFrame& out) const {
+    if (cursor.runLeft == 0) {
+        const std::vector<uint8_t>& bytes = _channels[side].bytes;
+        if (cursor.offset >= bytes.size()) return false;
+
+        size_t offset = cursor.offset;
+        uint8_t header = bytes[offset++];
+        uint32_t length = header >> 3;
+        if (length == RUN_LENGTH_INLINE) {
+            uint32_t rest;
+            if (!getVarint(bytes, offset, rest)) return false;
+            length += rest;
+        }
+
+        int fields = ((header & RUN_MOVE_X) ? 1 : 0) + ((header & RUN_MOVE_Y) ? 1 : 0) + ((header & RUN_BUTTONS) ? 1 : 0);
+        if (bytes.size() - offset < (size_t)fields) return false;
+        if (header & RUN_MOVE_X) cursor.frame.moveX = (int8_t)bytes[offset++];
+        if (header & RUN_MOVE_Y) cursor.frame.moveY = (int8_t)bytes[offset++];
+        if (header & RUN_BUTTONS) cursor.frame.buttons = bytes[offset++];
+
+        cursor.offset = offset;
+        cursor.runLeft = length + 1;
+    }
+
+    cursor.runLeft--;
+    out = cursor.frame;
+    return true;
+}
+
+size_t InputLog::getSize() {
+    finish();
+    size_t size = sizeof(MAGIC) + 1 + 8 + SIDE_COUNT * (3 * 4 + 4 + 4) + 4 + _checkpoints.size() * 12;
+    for (int i = 0; i < SIDE_COUNT; i++) size += _channels[i].bytes.size();
+    return size;
+}
+
+void InputLog::serialize(std::vector<uint8_t>& out) {
+    finish();
+    out.clear();
+    out.insert(out.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    out.push_back(VERSION);
+    putU64(out, _seed);
+
+    for (int i = 0; i < SIDE_COUNT; i++) {
+        putFloat(out, _lineups[i].speed);
+        putFloat(out, _lineups[i].shooting);
+        putFloat(out, _lineups[i].defense);
+    }
+    for (int i = 0; i < SIDE_COUNT; i++) {
+        const Channel& channel = _channels[i];
+        putU32(out, channel.frames);
+        putU32(out, (uint32_t)channel.bytes.size());
+        out.insert(out.end(), channel.bytes.begin(), channel.bytes.end());
+    }
+
+    putU32(out, (uint32_t)_checkpoints.size());
+    for (const Checkpoint& checkpoint : _checkpoints) {
+        putU32(out, checkpoint.tick);
+        putU64(out, checkpoint.hash);
+    }
+}
+
+bool InputLog::deserialize(const std::vector<uint8_t>& data) {
+    clear();
+
+    Reader in(data);
+    if (!in.take(sizeof(MAGIC)) || memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) return false;
+    in.offset += sizeof(MAGIC);
+    if (in.u8() != VERSION) return false;
+    _seed = in.u64();
+
+    for (int i = 0; i < SIDE_COUNT; i++) {
+        _lineups[i].speed = in.f32();
+        _lineups[i].shooting = in.f32();
+        _lineups[i].defense = in.f32();
+    }
+    for (int i = 0; i < SIDE_COUNT; i++) {
+        Channel& channel = _channels[i];
+        channel.frames = in.u32();
+        uint32_t size = in.u32();
+        if (!in.take(size)) break;
+        channel.bytes.assign(data.begin() + in.offset, data.begin() + in.offset + size);
+        in.offset += size;
+    }
+
+    uint32_t count = in.u32();
+    for (uint32_t i = 0; i < count && in.ok; i++) {
+        Checkpoint checkpoint;
+        checkpoint.tick = in.u32();
+        checkpoint.hash = in.u64();
+        _checkpoints.push_back(checkpoint);
+    }
+
+    if (!in.ok) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool InputLog::save(const std::string& path) {
+    std::vector<uint8_t> data;
+    serialize(data);
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+bool InputLog::load(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    fclose(file);
+    return deserialize(data);
+}
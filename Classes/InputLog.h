@@ -0,0 +1,135 @@
+#ifndef __INPUT_LOG_H__
+#define __INPUT_LOG_H__
+
+#include "cocos2d.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class PlayerController;
+
+// One tick of a controller's input. The move vector is quantized to 1/127
+// per axis; the live game plays the quantized frame too (see
+// RecordingController), so a replay sees exactly what the match saw.
+struct InputFrame {
+    enum Button : uint8_t {
+        SPRINT    = 1 << 0,
+        JUMP      = 1 << 1,
+        SHOOT     = 1 << 2,
+        PASS      = 1 << 3,
+        STEAL     = 1 << 4,
+        CROSSOVER = 1 << 5,
+        DEFEND    = 1 << 6
+    };
+
+    int8_t moveX;
+    int8_t moveY;
+    uint8_t buttons;
+
+    InputFrame() : moveX(0), moveY(0), buttons(0) {}
+
+    // Polls every getter once
+    static InputFrame capture(PlayerController* controller);
+
+    cocos2d::Vec2 getMove() const { return cocos2d::Vec2(moveX / 127.0f, moveY / 127.0f); }
+    bool isPressed(Button button) const { return (buttons & button) != 0; }
+
+    bool operator==(const InputFrame& other) const {
+        return moveX == other.moveX && moveY == other.moveY && buttons == other.buttons;
+    }
+    bool operator!=(const InputFrame& other) const { return !(*this == other); }
+};
+
+// A whole match as its inputs: the RNG seed, both line-ups and one
+// InputFrame per tick for each side. On an NBA2K_DETERMINISTIC build that is
+// enough to play the match again exactly, headless and at any speed (see
+// MatchReplay). A side's frames are stored as runs of identical input, each
+// a header byte (which fields changed, run length) plus the changed fields;
+// input rarely changes tick to tick, so a full match is a few KB.
+//
+// Checkpoints are state hashes taken while recording. Playback compares
+// against them, so a replay that drifted says where.
+class InputLog {
+public:
+    enum Side {
+        HOME,   // BasketballScene's human player, scored as "Player"
+        AWAY,   // Scored as "AI"
+        SIDE_COUNT
+    };
+
+    struct Lineup {
+        float speed;
+        float shooting;
+        float defense;
+
+        Lineup(float speed = 50.0f, float shooting = 50.0f, float defense = 50.0f)
+            : speed(speed), shooting(shooting), defense(defense) {}
+    };
+
+    struct Checkpoint {
+        uint32_t tick;      // Ticks run when the hash was taken
+        uint64_t hash;
+    };
+    static const uint32_t CHECKPOINT_INTERVAL = 600; // 10 s at the fixed step
+
+    // Read position in one side's frames. A plain value, so playback
+    // keyframes can copy it.
+    struct Cursor {
+        size_t offset;      // Next run header
+        uint32_t runLeft;   // Frames of the current run not yet read
+        InputFrame frame;   // The current run's frame
+
+        Cursor() : offset(0), runLeft(0) {}
+    };
+
+    InputLog();
+
+    void clear();
+
+    void setSeed(uint64_t seed) { _seed = seed; }
+    uint64_t getSeed() const { return _seed; }
+    void setLineup(Side side, const Lineup& lineup) { _lineups[side] = lineup; }
+    const Lineup& getLineup(Side side) const { return _lineups[side]; }
+
+    // Recording. Append one frame per side per tick; the open runs are
+    // written out by finish() (save() and getSize() call it).
+    void append(Side side, const InputFrame& frame);
+    void addCheckpoint(uint32_t tick, uint64_t hash);
+    void finish();
+
+    // Ticks recorded: the shorter side, if a match was cut off mid-tick
+    uint32_t getTickCount() const;
+    const std::vector<Checkpoint>& getCheckpoints() const { return _checkpoints; }
+
+    // Playback: the frame at 'cursor', which then moves on. False past the end.
+    bool read(Side side, Cursor& cursor, InputFrame& out) const;
+
+    // Encoded size in bytes, as save() writes it
+    size_t getSize();
+
+    // Little-endian, so a log recorded on one platform replays on another
+    void serialize(std::vector<uint8_t>& out);
+    bool deserialize(const std::vector<uint8_t>& data);
+    bool save(const std::string& path);
+    bool load(const std::string& path);
+
+private:
+    uint64_t _seed;
+    Lineup _lineups[SIDE_COUNT];
+    std::vector<Checkpoint> _checkpoints;
+
+    struct Channel {
+        std::vector<uint8_t> bytes;
+        uint32_t frames;        // Appended so far, open run included
+        InputFrame last;        // Last frame written out, what the next run's changes are against
+        InputFrame open;        // Frame of the run not yet written out
+        uint32_t openLength;
+
+        Channel() : frames(0), openLength(0) {}
+    };
+    Channel _channels[SIDE_COUNT];
+
+    static void writeRun(Channel& channel);
+};
+
+#endif // __INPUT_LOG_H__
@@ -9,7 +9,7 @@
 
 USING_NS_CC;
 
-MatchManager* MatchManager::_instance = nullptr;
+thread_local MatchManager* MatchManager::_instance = nullptr;
 
 MatchManager* MatchManager::getInstance() {
     if (!_instance) {
@@ -31,6 +31,8 @@ MatchManager::MatchManager()
     , _ball(nullptr)
     , _isJumpBallActive(false)
     , _jumpBallTimer(0.0f)
+    , _checkBallTimer(0.0f)
+    , _nextIsPlayerBall(true)
 {
 }
 
@@ -42,6 +44,10 @@ void MatchManager::init(Player* player, Player* aiPlayer, Basketball* ball) {
     _aiPlayer = aiPlayer;
     _ball = ball;
     
+#if NBA2K_HEADLESS
+    // Simulated matches always start fresh and never touch the save file
+    reset();
+#else
     // Init Save System
     SaveSystem::getInstance()->init();
     
@@ -61,6 +67,7 @@ void MatchManager::init(Player* player, Player* aiPlayer, Basketball* ball) {
     } else {
         reset();
     }
+#endif
 }
 
 void MatchManager::reset() {
@@ -68,6 +75,7 @@ void MatchManager::reset() {
     _aiStats = PlayerStats();
     _isJumpBallActive = false;
     _jumpBallTimer = 0.0f;
+    _checkBallTimer = 0.0f;
     ScoreManager::getInstance()->reset();
     
     // Reset Players
@@ -95,6 +103,15 @@ void MatchManager::update(float dt) {
         return;
     }
 
+    // Pending check ball after a goal (counted in game time, not by the Director's scheduler)
+    if (_checkBallTimer > 0.0f) {
+        _checkBallTimer -= dt;
+        if (_checkBallTimer <= 0.0f) {
+            _checkBallTimer = 0.0f;
+            startCheckBall(_nextIsPlayerBall);
+        }
+    }
+
     // Check Win Condition via ScoreManager
     if (ScoreManager::getInstance()->isGameOver()) {
         endMatch();
@@ -112,20 +129,26 @@ void MatchManager::startMatch() {
 void MatchManager::pauseMatch() {
     if (GameFlow::getInstance()->getState() == GameFlow::State::PLAYING) {
         GameFlow::getInstance()->changeState(GameFlow::State::PAUSED);
+#if !NBA2K_HEADLESS
         GameUI::getInstance()->showPauseMenu(true);
+#endif
     }
 }
 
 void MatchManager::resumeMatch() {
     if (GameFlow::getInstance()->getState() == GameFlow::State::PAUSED) {
         GameFlow::getInstance()->changeState(GameFlow::State::PLAYING);
+#if !NBA2K_HEADLESS
         GameUI::getInstance()->showPauseMenu(false);
+#endif
     }
 }
 
 void MatchManager::endMatch() {
     GameFlow::getInstance()->changeState(GameFlow::State::FINISHED);
+    _checkBallTimer = 0.0f;
     
+#if !NBA2K_HEADLESS
     std::string winner = ScoreManager::getInstance()->getWinner();
     bool isPlayerWin = (winner == "Player"); 
     
@@ -134,6 +157,7 @@ void MatchManager::endMatch() {
     SaveSystem::getInstance()->clearMatchProgress();
     
     GameUI::getInstance()->showGameOver(isPlayerWin);
+#endif
 }
 
 void MatchManager::handleGoal(bool isPlayerScored, int points) {
@@ -166,12 +190,9 @@ void MatchManager::handleGoal(bool isPlayerScored, int points) {
     // If Player scored, AI gets ball.
     bool nextIsPlayerBall = !isPlayerScored;
     
-    // Delay slightly before check ball?
-    // For now, immediate transition or maybe a small delay via GameFlow/Action
-    // We can use a delayed callback
-    cocos2d::Director::getInstance()->getScheduler()->schedule([this, nextIsPlayerBall](float dt){
-        startCheckBall(nextIsPlayerBall);
-    }, this, 2.0f, 0, 0.0f, false, "check_ball_delay");
+    // Check ball after a short delay (counted down in update)
+    _nextIsPlayerBall = nextIsPlayerBall;
+    _checkBallTimer = CHECK_BALL_DELAY;
 }
 
 void MatchManager::handleViolation(bool isPlayerViolation, const std::string& violationName) {
@@ -291,3 +312,69 @@ void MatchManager::recordAssist(bool isPlayer) {
     if (isPlayer) _playerStats.assists++;
     else _aiStats.assists++;
 }
+
+void MatchManager::recordPossession(bool isPlayer) {
+    if (isPlayer) _playerStats.possessions++;
+    else _aiStats.possessions++;
+}
+
+void MatchManager::recordShotClockViolation(bool isPlayer) {
+    if (isPlayer) _playerStats.shotClockViolations++;
+    else _aiStats.shotClockViolations++;
+}
+
+void MatchManager::snapshot(Snapshot& out) const {
+    out.playerStats = _playerStats;
+    out.aiStats = _aiStats;
+    out.random = _random;
+    out.isJumpBallActive = _isJumpBallActive;
+    out.jumpBallTimer = _jumpBallTimer;
+    out.checkBallTimer = _checkBallTimer;
+    out.nextIsPlayerBall = _nextIsPlayerBall;
+    ScoreManager::getInstance()->snapshot(out.score);
+    out.flow = GameFlow::getInstance()->getState();
+    _player->snapshot(out.player);
+    _aiPlayer->snapshot(out.aiPlayer);
+    _ball->snapshot(out.ball);
+}
+
+void MatchManager::restore(const Snapshot& snapshot) {
+    _playerStats = snapshot.playerStats;
+    _aiStats = snapshot.aiStats;
+    _random = snapshot.random;
+    _isJumpBallActive = snapshot.isJumpBallActive;
+    _jumpBallTimer = snapshot.jumpBallTimer;
+    _checkBallTimer = snapshot.checkBallTimer;
+    _nextIsPlayerBall = snapshot.nextIsPlayerBall;
+    ScoreManager::getInstance()->restore(snapshot.score);
+    GameFlow::getInstance()->restoreState(snapshot.flow);
+    _player->restore(snapshot.player);
+    _aiPlayer->restore(snapshot.aiPlayer);
+    _ball->restore(snapshot.ball);
+}
+
+void MatchManager::hashState(StateHash& hash) const {
+    ScoreManager* score = ScoreManager::getInstance();
+    hash.addInt(score->getPlayerScore());
+    hash.addInt(score->getAIScore());
+    hash.addFloat(score->getGameTime());
+    hash.addFloat(score->getShotClock());
+    hash.addInt(score->getCurrentQuarter());
+    hash.addInt((int)GameFlow::getInstance()->getState());
+
+    for (const Player* player : { _player, _aiPlayer }) {
+        hash.addInt((int)player->getState());
+        hash.addFloat(player->getStamina());
+        hash.addBool(player->hasBall());
+    }
+    hash.addInt((int)_ball->getState());
+    Player* owner = _ball->getOwner();
+    hash.addInt(owner == _player ? 1 : (owner == _aiPlayer ? 2 : 0));
+
+    MatchRandom random = _random; // The stream accessors aren't const
+    for (RandomStream* stream : { &random.shots(), &random.defense() }) {
+        uint32_t state[4];
+        stream->getState(state);
+        for (uint32_t word : state) hash.addBits(word);
+    }
+}
@@ -4,13 +4,19 @@
 #include "cocos2d.h"
 #include "Player.h"
 #include "Basketball.h"
+#include "MatchRandom.h"
+#include "ScoreManager.h"
+#include "GameFlow.h"
+#include "StateHash.h"
 
 struct PlayerStats {
     int points;
     int rebounds;
     int assists;
+    int possessions;
+    int shotClockViolations;
     
-    PlayerStats() : points(0), rebounds(0), assists(0) {}
+    PlayerStats() : points(0), rebounds(0), assists(0), possessions(0), shotClockViolations(0) {}
 };
 
 class MatchManager {
@@ -39,15 +45,47 @@ public:
     void recordPoint(bool isPlayer, int points);
     void recordRebound(bool isPlayer);
     void recordAssist(bool isPlayer);
+    void recordPossession(bool isPlayer);
+    void recordShotClockViolation(bool isPlayer);
     
     const PlayerStats& getPlayerStats() const { return _playerStats; }
     const PlayerStats& getAIStats() const { return _aiStats; }
 
+    // The match's RNG streams. Seed before the first tick; reset() keeps them.
+    MatchRandom& getRandom() { return _random; }
+    void seedRandom(uint64_t seed) { _random.reseed(seed); }
+
+    // The match's gameplay state beyond the physics world, for replay
+    // keyframes: this thread's match flow, scores and RNG plus the players
+    // and ball passed to init(). Restore the world last.
+    struct Snapshot {
+        PlayerStats playerStats;
+        PlayerStats aiStats;
+        MatchRandom random;
+        bool isJumpBallActive;
+        float jumpBallTimer;
+        float checkBallTimer;
+        bool nextIsPlayerBall;
+        ScoreManager::Snapshot score;
+        GameFlow::State flow;
+        Player::Snapshot player;
+        Player::Snapshot aiPlayer;
+        Basketball::Snapshot ball;
+    };
+    void snapshot(Snapshot& out) const;
+    void restore(const Snapshot& snapshot);
+
+    // Adds the gameplay state to 'hash': scores and clocks, match flow,
+    // players, ball, and the RNG streams gameplay draws from. The ai stream
+    // is left out (it only feeds AIController, which a replay doesn't run),
+    // and so is cosmetic (the game draws it per rendered frame).
+    void hashState(StateHash& hash) const;
+
 private:
     MatchManager();
     ~MatchManager();
 
-    static MatchManager* _instance;
+    static thread_local MatchManager* _instance; // One per thread, so headless matches can run in parallel
 
     Player* _player;
     Player* _aiPlayer;
@@ -56,8 +94,16 @@ private:
     PlayerStats _playerStats;
     PlayerStats _aiStats;
 
+    MatchRandom _random;
+
     bool _isJumpBallActive;
     float _jumpBallTimer;
+    
+    // Check ball pending after a goal
+    float _checkBallTimer;
+    bool _nextIsPlayerBall;
+    
+    const float CHECK_BALL_DELAY = 2.0f;
 };
 
 #endif // __MATCH_MANAGER_H__
@@ -0,0 +1,111 @@
+#ifndef __MATCH_RANDOM_H__
+#define __MATCH_RANDOM_H__
+
+#include <cstdint>
+
+// xoshiro128** generator: 16 bytes of state, a handful of integer ops per
+// draw. Plain value type, so copying a stream snapshots it.
+class RandomStream {
+public:
+    explicit RandomStream(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        // SplitMix64 spreads any seed (including 0) over the whole state
+        for (int k = 0; k < 4; k += 2) {
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z ^= z >> 31;
+            _s[k] = (uint32_t)z;
+            _s[k + 1] = (uint32_t)(z >> 32);
+        }
+    }
+
+    uint32_t nextU32() {
+        uint32_t result = rotl(_s[1] * 5, 7) * 9;
+        uint32_t t = _s[1] << 9;
+        _s[2] ^= _s[0];
+        _s[3] ^= _s[1];
+        _s[1] ^= _s[2];
+        _s[0] ^= _s[3];
+        _s[2] ^= t;
+        _s[3] = rotl(_s[3], 11);
+        return result;
+    }
+
+    // Uniform in [0, 1)
+    float nextFloat() { return (nextU32() >> 8) * (1.0f / 16777216.0f); }
+
+    // Uniform in [low, high)
+    float range(float low, float high) { return low + (high - low) * nextFloat(); }
+
+    // Child stream that starts where this one is; this one then jumps 2^64
+    // draws ahead, so the two never overlap
+    RandomStream split() {
+        RandomStream child = *this;
+        jump();
+        return child;
+    }
+
+    // Raw generator state (for state hashes)
+    void getState(uint32_t out[4]) const {
+        for (int k = 0; k < 4; ++k) out[k] = _s[k];
+    }
+
+private:
+    uint32_t _s[4];
+
+    static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+    void jump() {
+        static const uint32_t JUMP[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+        uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (uint32_t word : JUMP) {
+            for (int b = 0; b < 32; ++b) {
+                if (word & (1u << b)) {
+                    s0 ^= _s[0];
+                    s1 ^= _s[1];
+                    s2 ^= _s[2];
+                    s3 ^= _s[3];
+                }
+                nextU32();
+            }
+        }
+        _s[0] = s0;
+        _s[1] = s1;
+        _s[2] = s2;
+        _s[3] = s3;
+    }
+};
+
+// A match's randomness, owned by MatchManager. One stream per consumer, so
+// e.g. an extra cosmetic roll can't change a shot's outcome, and two
+// matches seeded the same play the same. Copy it to snapshot all streams.
+class MatchRandom {
+public:
+    explicit MatchRandom(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        _seed = seed;
+        RandomStream root(seed);
+        _ai = root.split();
+        _shots = root.split();
+        _defense = root.split();
+        _cosmetic = root.split();
+    }
+    uint64_t getSeed() const { return _seed; }
+
+    RandomStream& ai() { return _ai; }             // AIBrain decisions
+    RandomStream& shots() { return _shots; }       // ShotCalculator
+    RandomStream& defense() { return _defense; }   // Steals, blocks, crossovers, fumbles
+    RandomStream& cosmetic() { return _cosmetic; } // Effects that don't affect play
+
+private:
+    uint64_t _seed;
+    RandomStream _ai;
+    RandomStream _shots;
+    RandomStream _defense;
+    RandomStream _cosmetic;
+};
+
+#endif // __MATCH_RANDOM_H__
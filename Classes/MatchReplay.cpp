@@ -0,0 +1,62 @@
+#include "MatchReplay.h"
+#include <algorithm>
+
+MatchReplay::MatchReplay(const InputLog& log)
+    : _log(log)
+    , _match(HeadlessMatch::Config::forReplay(log))
+    , _furthestTick(0)
+    , _checkpointsVerified(0)
+    , _divergedAt(-1)
+{
+    _match.startReplay(&_log);
+
+    _keyframes.emplace_back();
+    _match.saveKeyframe(_keyframes.back());
+}
+
+bool MatchReplay::step() {
+    bool more = _match.step();
+
+    // Ticks after a seek back have been checked already
+    int tick = getTick();
+    if (tick > _furthestTick) {
+        _furthestTick = tick;
+        verifyCheckpoint(tick);
+        if (tick % KEYFRAME_INTERVAL == 0) {
+            _keyframes.emplace_back();
+            _match.saveKeyframe(_keyframes.back());
+        }
+    }
+    return more;
+}
+
+void MatchReplay::playToEnd() {
+    while (step()) {}
+}
+
+void MatchReplay::seek(int tick) {
+    if (tick < 0) tick = 0;
+
+    // Jump to a keyframe when going back, or when one is closer than here
+    size_t k = std::min((size_t)(tick / KEYFRAME_INTERVAL), _keyframes.size() - 1);
+    if (tick < getTick() || (int)k * KEYFRAME_INTERVAL > getTick()) {
+        if (!_match.loadKeyframe(_keyframes[k])) {
+            CCLOGERROR("MatchReplay: keyframe %d doesn't fit the world", (int)k * KEYFRAME_INTERVAL);
+            return;
+        }
+    }
+
+    while (getTick() < tick && step()) {}
+}
+
+void MatchReplay::verifyCheckpoint(int tick) {
+    const std::vector<InputLog::Checkpoint>& checkpoints = _log.getCheckpoints();
+    auto it = std::lower_bound(checkpoints.begin(), checkpoints.end(), (uint32_t)tick,
+        [](const InputLog::Checkpoint& checkpoint, uint32_t t) { return checkpoint.tick < t; });
+    if (it == checkpoints.end() || it->tick != (uint32_t)tick) return;
+
+    _checkpointsVerified++;
+    if (it->hash != _match.getTickHash() && _divergedAt < 0) {
+        _divergedAt = tick;
+    }
+}
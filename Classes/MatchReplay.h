@@ -0,0 +1,46 @@
+#ifndef __MATCH_REPLAY_H__
+#define __MATCH_REPLAY_H__
+
+#include "HeadlessMatch.h"
+#include "InputLog.h"
+#include <vector>
+
+// Plays an InputLog back headless, as fast as the CPU allows, and scrubs
+// through it. Playback keeps a keyframe every KEYFRAME_INTERVAL ticks the
+// first time it gets there, so seek() restores the nearest keyframe at or
+// before the target and re-simulates at most that many ticks. The log's
+// checkpoint hashes are checked on the way; a mismatch means this build
+// doesn't play the match the way the recording build did.
+class MatchReplay {
+public:
+    static const int KEYFRAME_INTERVAL = 300; // 5 s at the fixed step
+
+    // 'log' must outlive the replay
+    explicit MatchReplay(const InputLog& log);
+
+    // Advances one tick; returns false at the end of the log
+    bool step();
+    void playToEnd();
+    // Past the end of the log stops at the end
+    void seek(int tick);
+
+    int getTick() const { return _match.getResult().ticks; }
+    int getTickCount() const { return (int)_log.getTickCount(); }
+    HeadlessMatch& getMatch() { return _match; }
+
+    // Checkpoints compared so far, and the tick of the first that differed (-1 if none)
+    int getCheckpointsVerified() const { return _checkpointsVerified; }
+    int getDivergedAt() const { return _divergedAt; }
+
+private:
+    const InputLog& _log;
+    HeadlessMatch _match;
+    std::vector<HeadlessMatch::Keyframe> _keyframes; // [k] is tick k * KEYFRAME_INTERVAL
+    int _furthestTick;                               // Keyframes and checkpoints are done up to here
+    int _checkpointsVerified;
+    int _divergedAt;
+
+    void verifyCheckpoint(int tick);
+};
+
+#endif // __MATCH_REPLAY_H__
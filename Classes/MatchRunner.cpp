@@ -0,0 +1,274 @@
+#include "MatchRunner.h"
+#include "ScoreManager.h"
+#include "MatchManager.h"
+#include "GameFlow.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+static const double Z_95 = 1.959964; // Two-sided 95% normal quantile
+
+static const char* difficultyName(AIBrain::Difficulty difficulty) {
+    switch (difficulty) {
+        case AIBrain::Difficulty::EASY: return "easy";
+        case AIBrain::Difficulty::NORMAL: return "normal";
+        case AIBrain::Difficulty::HARD: return "hard";
+    }
+    return "unknown";
+}
+
+static void writeSide(FILE* out, const HeadlessMatch::Side& side) {
+    std::fprintf(out, "{\"difficulty\":\"%s\",\"speed\":%g,\"shooting\":%g,\"defense\":%g}",
+                 difficultyName(side.difficulty), side.speed, side.shooting, side.defense);
+}
+
+static void writeEstimate(FILE* out, const char* name, const MatchRunner::Estimate& e) {
+    std::fprintf(out, "\"%s\":{\"mean\":%.4f,\"low\":%.4f,\"high\":%.4f}", name, e.mean, e.low, e.high);
+}
+
+void MatchRunner::Sample::add(double x) {
+    count++;
+    double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+}
+
+MatchRunner::Estimate MatchRunner::Sample::estimate() const {
+    Estimate e;
+    e.mean = mean;
+    double halfWidth = 0.0;
+    if (count > 1) {
+        halfWidth = Z_95 * std::sqrt(m2 / (count - 1) / count);
+    }
+    e.low = mean - halfWidth;
+    e.high = mean + halfWidth;
+    return e;
+}
+
+MatchRunner::Estimate MatchRunner::VariantStats::homeWinRate() const {
+    Estimate e;
+    if (matches == 0) {
+        e.mean = e.low = e.high = 0.0;
+        return e;
+    }
+    double n = (double)matches;
+    double p = homeWins / n;
+    double z2 = Z_95 * Z_95;
+    double center = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+    double halfWidth = Z_95 * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+    e.mean = p;
+    e.low = std::max(0.0, center - halfWidth);
+    e.high = std::min(1.0, center + halfWidth);
+    return e;
+}
+
+MatchRunner::MatchRunner(int threads)
+    : _threadCount(threads > 0 ? threads : std::max(1, (int)std::thread::hardware_concurrency()))
+    , _verify(false)
+    , _queues(_threadCount)
+    , _out(nullptr)
+    , _matchesRun(0)
+    , _diverged(0)
+    , _simulatedSeconds(0.0)
+    , _wallSeconds(0.0)
+{}
+
+void MatchRunner::addVariant(const HeadlessMatch::Config& config) {
+    _variants.push_back(config);
+    _stats.push_back(VariantStats());
+}
+
+double MatchRunner::getMatchesPerSecondPerCore() const {
+    if (_wallSeconds <= 0.0) return 0.0;
+    return _matchesRun / _wallSeconds / _threadCount;
+}
+
+uint64_t MatchRunner::matchSeed(uint64_t baseSeed, uint32_t variant, uint32_t match) {
+    // SplitMix64 finalizer over the match's coordinates
+    uint64_t z = baseSeed + (((uint64_t)variant << 32) | match) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void MatchRunner::run(int matchesPerVariant, uint64_t baseSeed, FILE* out) {
+    _out = out;
+    _matchesRun = 0;
+    _diverged = 0;
+    _simulatedSeconds = 0.0;
+    for (auto& s : _stats) s = VariantStats();
+
+    // Deal the jobs out in contiguous shares; the order interleaves variants
+    // so every variant makes progress from the start
+    size_t total = _variants.size() * (size_t)std::max(0, matchesPerVariant);
+    for (size_t k = 0; k < total; ++k) {
+        Job job;
+        job.variant = (uint32_t)(k % _variants.size());
+        job.match = (uint32_t)(k / _variants.size());
+        _queues[k * _threadCount / total].jobs.push_back(job);
+    }
+
+    HeadlessMatch::initSharedState();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    threads.reserve(_threadCount - 1);
+    for (int w = 1; w < _threadCount; ++w) {
+        threads.push_back(std::thread(&MatchRunner::workerLoop, this, w, baseSeed));
+    }
+    workerLoop(0, baseSeed);
+    for (auto& t : threads) {
+        t.join();
+    }
+    _wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    writeSummary();
+}
+
+bool MatchRunner::takeJob(int worker, Job& job) {
+    {
+        WorkQueue& own = _queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = own.jobs.front();
+            own.jobs.pop_front();
+            return true;
+        }
+    }
+
+    // Steal from the back of the fullest queue. No jobs are added once the
+    // batch has started, so finding every queue empty means we're done.
+    for (;;) {
+        int victim = -1;
+        size_t most = 0;
+        for (int w = 0; w < _threadCount; ++w) {
+            if (w == worker) continue;
+            std::lock_guard<std::mutex> lock(_queues[w].mutex);
+            if (_queues[w].jobs.size() > most) {
+                most = _queues[w].jobs.size();
+                victim = w;
+            }
+        }
+        if (victim < 0) return false;
+
+        WorkQueue& other = _queues[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.jobs.empty()) {
+            job = other.jobs.back();
+            other.jobs.pop_back();
+            return true;
+        }
+    }
+}
+
+void MatchRunner::workerLoop(int worker, uint64_t baseSeed) {
+    Job job;
+    std::vector<uint64_t> tickHashes;
+    while (takeJob(worker, job)) {
+        HeadlessMatch::Config config = _variants[job.variant];
+        config.seed = matchSeed(baseSeed, job.variant, job.match);
+
+        if (!_verify) {
+            HeadlessMatch match(config);
+            record(job, config.seed, match.run(), -1);
+            continue;
+        }
+
+        // The thread's game-flow singletons allow one match at a time, so
+        // the replay runs after the original and checks it tick by tick
+        HeadlessMatch::Result result;
+        tickHashes.clear();
+        {
+            HeadlessMatch match(config);
+            bool running = true;
+            while (running) {
+                running = match.step();
+                tickHashes.push_back(match.getTickHash());
+            }
+            result = match.getResult();
+        }
+        int divergedAt = -1;
+        {
+            HeadlessMatch replay(config);
+            bool running = true;
+            for (size_t tick = 0; running; ++tick) {
+                running = replay.step();
+                if (tick >= tickHashes.size() || replay.getTickHash() != tickHashes[tick]) {
+                    divergedAt = (int)tick;
+                    break;
+                }
+            }
+            if (divergedAt < 0 && replay.getResult().ticks != result.ticks) divergedAt = replay.getResult().ticks;
+        }
+        record(job, config.seed, result, divergedAt);
+    }
+
+    // The game-flow singletons are per thread
+    if (worker != 0) {
+        MatchManager::destroyInstance();
+        ScoreManager::destroyInstance();
+        GameFlow::destroyInstance();
+    }
+}
+
+void MatchRunner::record(const Job& job, uint64_t seed, const HeadlessMatch::Result& r, int divergedAt) {
+    std::lock_guard<std::mutex> lock(_outputMutex);
+
+    VariantStats& s = _stats[job.variant];
+    s.matches++;
+    if (!r.finished) s.unfinished++;
+    int winner = r.winner();
+    s.homeWins += (winner > 0) ? 1.0 : (winner == 0 ? 0.5 : 0.0);
+    if (r.homePossessions > 0) s.homePointsPerPossession.add((double)r.homeScore / r.homePossessions);
+    if (r.awayPossessions > 0) s.awayPointsPerPossession.add((double)r.awayScore / r.awayPossessions);
+    s.shotClockViolations.add(r.homeShotClockViolations + r.awayShotClockViolations);
+
+    _matchesRun++;
+    if (divergedAt >= 0) _diverged++;
+    _simulatedSeconds += r.gameSeconds;
+
+    if (!_out) return;
+    std::fprintf(_out,
+                 "{\"type\":\"match\",\"variant\":%u,\"match\":%u,\"seed\":%llu,"
+                 "\"home\":%d,\"away\":%d,\"homePossessions\":%d,\"awayPossessions\":%d,"
+                 "\"homeShotClock\":%d,\"awayShotClock\":%d,\"seconds\":%.2f,\"ticks\":%d,\"finished\":%s,"
+                 "\"hash\":\"%016llx\"",
+                 job.variant, job.match, (unsigned long long)seed,
+                 r.homeScore, r.awayScore, r.homePossessions, r.awayPossessions,
+                 r.homeShotClockViolations, r.awayShotClockViolations,
+                 r.gameSeconds, r.ticks, r.finished ? "true" : "false",
+                 (unsigned long long)r.stateHash);
+    if (_verify) std::fprintf(_out, ",\"divergedAt\":%d", divergedAt);
+    std::fprintf(_out, "}\n");
+    std::fflush(_out);
+}
+
+void MatchRunner::writeSummary() {
+    if (!_out) return;
+
+    for (size_t v = 0; v < _variants.size(); ++v) {
+        const VariantStats& s = _stats[v];
+        std::fprintf(_out, "{\"type\":\"variant\",\"variant\":%u,\"home\":", (unsigned)v);
+        writeSide(_out, _variants[v].home);
+        std::fprintf(_out, ",\"away\":");
+        writeSide(_out, _variants[v].away);
+        std::fprintf(_out, ",\"matches\":%ld,\"unfinished\":%ld,", s.matches, s.unfinished);
+        writeEstimate(_out, "homeWinRate", s.homeWinRate());
+        std::fprintf(_out, ",");
+        writeEstimate(_out, "homePointsPerPossession", s.homePointsPerPossession.estimate());
+        std::fprintf(_out, ",");
+        writeEstimate(_out, "awayPointsPerPossession", s.awayPointsPerPossession.estimate());
+        std::fprintf(_out, ",");
+        writeEstimate(_out, "shotClockViolations", s.shotClockViolations.estimate());
+        std::fprintf(_out, "}\n");
+    }
+
+    std::fprintf(_out,
+                 "{\"type\":\"throughput\",\"matches\":%ld,\"threads\":%d,\"verified\":%s,\"diverged\":%ld,\"wallSeconds\":%.3f,"
+                 "\"simulatedSeconds\":%.1f,\"matchesPerSecond\":%.2f,\"matchesPerSecondPerCore\":%.2f}\n",
+                 _matchesRun, _threadCount, _verify ? "true" : "false", _diverged, _wallSeconds, _simulatedSeconds,
+                 _wallSeconds > 0.0 ? _matchesRun / _wallSeconds : 0.0,
+                 getMatchesPerSecondPerCore());
+    std::fflush(_out);
+}
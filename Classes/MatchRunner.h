@@ -0,0 +1,103 @@
+#ifndef __MATCH_RUNNER_H__
+#define __MATCH_RUNNER_H__
+
+#include "HeadlessMatch.h"
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+// Monte Carlo batch of headless matches over a set of line-ups (variants).
+// Every variant plays the same number of matches, each with its own seed.
+// Matches are spread over a work-stealing pool: each thread starts with a
+// contiguous share and, once it runs dry, takes from the back of the
+// fullest other queue. Every finished match is written to 'out' as one JSON
+// line straight away, so a long sweep can be read while it runs; the
+// per-variant aggregates follow once the batch is done.
+class MatchRunner {
+public:
+    // Mean with a 95% confidence interval
+    struct Estimate {
+        double mean;
+        double low;
+        double high;
+    };
+
+    // Running mean / variance (Welford)
+    struct Sample {
+        long count;
+        double mean;
+        double m2;
+
+        Sample() : count(0), mean(0.0), m2(0.0) {}
+        void add(double x);
+        Estimate estimate() const;
+    };
+
+    struct VariantStats {
+        long matches;
+        long unfinished;
+        double homeWins;            // A draw counts as half a win
+        Sample homePointsPerPossession;
+        Sample awayPointsPerPossession;
+        Sample shotClockViolations; // Both sides, per match
+
+        VariantStats() : matches(0), unfinished(0), homeWins(0.0) {}
+        Estimate homeWinRate() const; // Wilson score interval
+    };
+
+    // threads <= 0 uses every core
+    explicit MatchRunner(int threads = 0);
+
+    void addVariant(const HeadlessMatch::Config& config);
+    size_t getVariantCount() const { return _variants.size(); }
+
+    // Play every match twice and compare the state hash tick by tick. A match
+    // whose replay diverges is reported with the first tick that differed.
+    void setVerify(bool verify) { _verify = verify; }
+    long getDivergedCount() const { return _diverged; }
+
+    // Plays matchesPerVariant matches of every variant. Seeds are derived
+    // from baseSeed, the variant and the match number.
+    void run(int matchesPerVariant, uint64_t baseSeed, FILE* out);
+
+    const VariantStats& getStats(size_t variant) const { return _stats[variant]; }
+    int getThreadCount() const { return _threadCount; }
+    long getMatchCount() const { return _matchesRun; }
+    double getWallSeconds() const { return _wallSeconds; }
+    double getSimulatedSeconds() const { return _simulatedSeconds; }
+    double getMatchesPerSecondPerCore() const;
+
+private:
+    struct Job {
+        uint32_t variant;
+        uint32_t match;
+    };
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    int _threadCount;
+    bool _verify;
+    std::vector<HeadlessMatch::Config> _variants;
+    std::vector<VariantStats> _stats;
+    std::vector<WorkQueue> _queues;
+
+    std::mutex _outputMutex;        // Guards 'out' and the totals below
+    FILE* _out;
+    long _matchesRun;
+    long _diverged;
+    double _simulatedSeconds;
+    double _wallSeconds;
+
+    bool takeJob(int worker, Job& job);
+    void workerLoop(int worker, uint64_t baseSeed);
+    void record(const Job& job, uint64_t seed, const HeadlessMatch::Result& result, int divergedAt);
+    void writeSummary();
+
+    static uint64_t matchSeed(uint64_t baseSeed, uint32_t variant, uint32_t match);
+};
+
+#endif // __MATCH_RUNNER_H__
@@ -0,0 +1,95 @@
+#include "PairTable.h"
+
+PairTable::PairTable() : _count(0) {}
+
+void PairTable::clear() {
+    for (auto& slot : _slots) slot.key = EMPTY_KEY;
+    _count = 0;
+}
+
+void PairTable::reserve(size_t count) {
+    // Stay at or below half full
+    size_t capacity = 16;
+    while (capacity < count * 2) capacity *= 2;
+    if (capacity <= _slots.size()) return;
+
+    std::vector<Slot> old;
+    old.swap(_slots);
+    _slots.assign(capacity, Slot{EMPTY_KEY, 0});
+    _count = 0;
+    for (const auto& slot : old) {
+        if (slot.key != EMPTY_KEY) set(slot.key, slot.value);
+    }
+}
+
+size_t PairTable::home(uint64_t key) const {
+    // Fibonacci hashing spreads the (index << 32 | index) keys well
+    return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (_slots.size() - 1);
+}
+
+void PairTable::grow() {
+    reserve(_slots.empty() ? 8 : _slots.size());
+}
+
+bool PairTable::find(uint64_t key, uint32_t& value) const {
+    if (_slots.empty()) return false;
+    size_t mask = _slots.size() - 1;
+    for (size_t i = home(key);; i = (i + 1) & mask) {
+        const Slot& slot = _slots[i];
+        if (slot.key == key) {
+            value = slot.value;
+            return true;
+        }
+        if (slot.key == EMPTY_KEY) return false;
+    }
+}
+
+bool PairTable::contains(uint64_t key) const {
+    uint32_t value;
+    return find(key, value);
+}
+
+void PairTable::set(uint64_t key, uint32_t value) {
+    if ((_count + 1) * 2 > _slots.size()) grow();
+
+    size_t mask = _slots.size() - 1;
+    for (size_t i = home(key);; i = (i + 1) & mask) {
+        Slot& slot = _slots[i];
+        if (slot.key == key) {
+            slot.value = value;
+            return;
+        }
+        if (slot.key == EMPTY_KEY) {
+            slot.key = key;
+            slot.value = value;
+            _count++;
+            return;
+        }
+    }
+}
+
+bool PairTable::erase(uint64_t key) {
+    if (_slots.empty()) return false;
+    size_t mask = _slots.size() - 1;
+
+    size_t i = home(key);
+    while (_slots[i].key != key) {
+        if (_slots[i].key == EMPTY_KEY) return false;
+        i = (i + 1) & mask;
+    }
+
+    // Backward-shift: pull later entries of the probe run into the hole
+    // when the hole lies between their home slot and their current slot
+    size_t hole = i;
+    for (size_t j = (hole + 1) & mask; _slots[j].key != EMPTY_KEY; j = (j + 1) & mask) {
+        size_t h = home(_slots[j].key);
+        bool movable = (hole <= j) ? (h <= hole || h > j) : (h <= hole && h > j);
+        if (movable) {
+            _slots[hole] = _slots[j];
+            hole = j;
+        }
+    }
+    _slots[hole].key = EMPTY_KEY;
+    _count--;
+    return true;
+}
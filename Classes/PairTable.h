@@ -0,0 +1,39 @@
+#ifndef __PAIR_TABLE_H__
+#define __PAIR_TABLE_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Open-addressing hash map from a 64-bit pair key to a 32-bit slot index.
+// Linear probing with backward-shift deletion, so there are no tombstones and
+// inserts / erases never touch the heap once the table has grown to size.
+class PairTable {
+public:
+    static const uint64_t EMPTY_KEY = ~0ull; // Never a valid pair key (a < b)
+
+    PairTable();
+
+    void clear();             // Keeps capacity
+    void reserve(size_t count);
+    size_t size() const { return _count; }
+
+    bool find(uint64_t key, uint32_t& value) const;
+    bool contains(uint64_t key) const;
+    void set(uint64_t key, uint32_t value);   // Insert or overwrite
+    bool erase(uint64_t key);
+
+private:
+    struct Slot {
+        uint64_t key;
+        uint32_t value;
+    };
+
+    std::vector<Slot> _slots;  // Power-of-two size
+    size_t _count;
+
+    size_t home(uint64_t key) const;
+    void grow();
+};
+
+#endif // __PAIR_TABLE_H__
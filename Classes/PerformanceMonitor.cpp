@@ -24,6 +24,7 @@ PerformanceMonitor::PerformanceMonitor()
     , _drawCalls(0)
     , _collisionChecks(0)
     , _entityCount(0)
+    , _integrations(0)
     , _fpsTimer(0.0f)
     , _frameCount(0)
     , _currentFPS(60.0f)
@@ -77,10 +78,11 @@ void PerformanceMonitor::updateLabel() {
     _drawCalls = (int)Director::getInstance()->getRenderer()->getDrawnBatches();
     
     std::string info = StringUtils::format(
-        "FPS: %.1f\nEntities: %d\nCollisions: %d\nDraw Calls: %d", 
+        "FPS: %.1f\nEntities: %d\nCollisions: %d\nIntegrations: %d\nDraw Calls: %d", 
         _currentFPS,
         _entityCount,
         _collisionChecks,
+        _integrations,
         _drawCalls
     );
     
@@ -19,6 +19,7 @@ public:
     void recordDrawCall(int count) { _drawCalls = count; } // Usually pulled from renderer
     void recordCollisionChecks(int count) { _collisionChecks = count; }
     void recordEntityCount(int count) { _entityCount = count; }
+    void recordIntegrations(int count) { _integrations = count; }
 
 private:
     PerformanceMonitor();
@@ -33,6 +34,7 @@ private:
     int _drawCalls;
     int _collisionChecks;
     int _entityCount;
+    int _integrations;
     float _fpsTimer;
     int _frameCount;
     float _currentFPS;
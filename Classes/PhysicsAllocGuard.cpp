@@ -0,0 +1,73 @@
+#include "PhysicsAllocGuard.h"
+#include "cocos2d.h"
+
+#if PHYSICS_ALLOC_GUARD
+
+#include <cstdlib>
+#include <new>
+
+static thread_local bool t_counting = false;
+static thread_local int t_count = 0;
+
+static void* countedAlloc(std::size_t size) {
+    if (t_counting) t_count++;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace PhysicsAllocGuard {
+
+int getCount() {
+    return t_count;
+}
+
+Scope::Scope(bool armed) : _armed(armed), _wasCounting(t_counting), _startCount(t_count) {
+    if (_armed) t_counting = true;
+}
+
+Scope::~Scope() {
+    if (!_armed) return;
+    t_counting = _wasCounting;
+
+    int allocations = t_count - _startCount;
+    if (allocations > 0) {
+        CCLOG("PhysicsAllocGuard: %d heap allocation(s) inside the physics step", allocations);
+        CCASSERT(allocations == 0, "Physics step allocated after warm-up");
+    }
+}
+
+} // namespace PhysicsAllocGuard
+
+#else
+
+namespace PhysicsAllocGuard {
+
+int getCount() { return 0; }
+
+Scope::Scope(bool armed) : _armed(armed), _wasCounting(false), _startCount(0) {}
+Scope::~Scope() {}
+
+} // namespace PhysicsAllocGuard
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef __PHYSICS_ALLOC_GUARD_H__
+#define __PHYSICS_ALLOC_GUARD_H__
+
+// Debug check that the physics step doesn't touch the heap.
+// Build with PHYSICS_ALLOC_GUARD=1 (CMake option NBA2K_PHYSICS_ALLOC_GUARD) to
+// replace the global operator new with a counting one; heap allocations made
+// on the current thread while a Scope is armed are counted, and the scope
+// asserts on exit if there were any.
+#ifndef PHYSICS_ALLOC_GUARD
+#define PHYSICS_ALLOC_GUARD 0
+#endif
+
+namespace PhysicsAllocGuard {
+    // Allocations counted on this thread since the outermost armed Scope began
+    int getCount();
+
+    class Scope {
+    public:
+        explicit Scope(bool armed);
+        ~Scope();
+    private:
+        bool _armed;
+        bool _wasCounting;
+        int _startCount;
+    };
+}
+
+#endif // __PHYSICS_ALLOC_GUARD_H__
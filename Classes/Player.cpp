@@ -6,14 +6,19 @@
 #include "ShootingSystem.h"
 #include "DribbleSystem.h"
 #include "DefenseSystem.h"
+#include "DeterministicMath.h"
 #include "2d/CCCamera.h"
 #include "2d/CCScene.h"
 
 USING_NS_CC;
 
 Player* Player::create() {
+    return create(CollisionSystem::getInstance());
+}
+
+Player* Player::create(CollisionSystem* world) {
     Player* pRet = new (std::nothrow) Player();
-    if (pRet && pRet->init()) {
+    if (pRet && pRet->init(world)) {
         pRet->autorelease();
         return pRet;
     }
@@ -35,8 +40,13 @@ Player::~Player() {
 }
 
 bool Player::init() {
+    return init(CollisionSystem::getInstance());
+}
+
+bool Player::init(CollisionSystem* world) {
     if (!Node::init()) return false;
     
+    _world = world;
     _controller = nullptr;
     _ball = nullptr;
     _hasBall = false;
@@ -52,13 +62,22 @@ bool Player::init() {
     _pickupCooldown = 0.0f;
     _mustClearBall = false;
     _stamina = 1.0f;
+    _recoveryTimer = 0.0f;
+    _celebrationTimer = 0.0f;
+    _clock = 0.0f;
+    
+    _trajectoryNode = nullptr;
+    _staminaNode = nullptr;
+    _model = nullptr;
+    _animPlayer = nullptr;
     
-    // Visuals
+    // Visuals (the facing is kept on _visualNode, so it exists headless too)
     setCascadeColorEnabled(true);
     _visualNode = Node::create();
     _visualNode->setCascadeColorEnabled(true);
     addChild(_visualNode);
     
+#if !NBA2K_HEADLESS
     _trajectoryNode = DrawNode::create();
     if (_trajectoryNode) {
         _trajectoryNode->retain(); // Keep it alive, will be added to Scene later
@@ -98,6 +117,7 @@ bool Player::init() {
     if (_animPlayer) {
         _animPlayer->retain(); // Keep it alive
     }
+#endif
     
     // Shooting System
     _shootingSystem = ShootingSystem::create(this);
@@ -123,10 +143,13 @@ bool Player::init() {
     _body->setMass(80.0f); // 80kg
     _body->setMaterial(SimplePhysicsMaterial(0.0f, 0.2f)); // No bounce, low friction
     _body->setUserData(this);
+    _body->setNode(this);
     
-    CollisionSystem::getInstance()->addBody(_body);
+    world->addBody(_body);
     
-    scheduleUpdate();
+#if !NBA2K_DETERMINISTIC
+    scheduleUpdate(); // Deterministic builds step players in BasketballScene::tick
+#endif
     
     return true;
 }
@@ -232,11 +255,8 @@ void Player::jump() {
 }
 
 void Player::update(float dt) {
-    if (_body) {
-        // Sync visual with physics (Interpolated)
-        float alpha = CollisionSystem::getInstance()->getAlpha();
-        Node::setPosition3D(_body->getInterpolatedPosition(alpha));
-    }
+    // The node follows the body through CollisionSystem::syncNodes
+    _clock += dt;
     
     // Update Systems
     if (_shootingSystem) {
@@ -257,7 +277,9 @@ void Player::update(float dt) {
         _controller->update(dt);
     }
     
+#if !NBA2K_HEADLESS
     updateVisuals();
+#endif
 }
 
 void Player::celebrate() {
@@ -390,12 +412,12 @@ void Player::handleMovement(float dt) {
              dir.y = 0; // Ignore height difference
              if (dir.lengthSquared() > 0.01f) {
                  dir.normalize();
-                 float angle = atan2(dir.x, dir.z);
+                 float angle = DeterministicMath::atan2(dir.x, dir.z);
                  _visualNode->setRotation3D(Vec3(0, CC_RADIANS_TO_DEGREES(angle), 0));
              }
         } else {
              // Face movement direction
-             float angle = atan2(dir.x, dir.z);
+             float angle = DeterministicMath::atan2(dir.x, dir.z);
              _visualNode->setRotation3D(Vec3(0, CC_RADIANS_TO_DEGREES(angle), 0));
         }
         
@@ -440,7 +462,7 @@ void Player::handleMovement(float dt) {
               dir.y = 0;
               if (dir.lengthSquared() > 0.01f) {
                   dir.normalize();
-                  float angle = atan2(dir.x, dir.z);
+                  float angle = DeterministicMath::atan2(dir.x, dir.z);
                   _visualNode->setRotation3D(Vec3(0, CC_RADIANS_TO_DEGREES(angle), 0));
               }
           }
@@ -588,15 +610,16 @@ void Player::updateBallPosition() {
         float angle = CC_DEGREES_TO_RADIANS(_visualNode->getRotation3D().y);
         
         // Base offset: in front and slightly to right (right hand dribble)
-        Vec3 offset(sin(angle) * 0.5f + cos(angle) * 0.3f, 0, cos(angle) * 0.5f - sin(angle) * 0.3f);
+        float s = DeterministicMath::sin(angle);
+        float c = DeterministicMath::cos(angle);
+        Vec3 offset(s * 0.5f + c * 0.3f, 0, c * 0.5f - s * 0.3f);
         Vec3 handPos = getPosition3D() + offset;
         
         if (_state == State::DRIBBLING) {
             // Dynamic height for dribbling
             // Bounce frequency: 2.0 bounces per second? 
-            // Use system time or internal timer? We don't have a timer passed here, use Director time
-            float time = Director::getInstance()->getTotalFrames() * Director::getInstance()->getAnimationInterval();
-            float bounceHeight = 0.8f + abs(sin(time * 10.0f)) * 0.8f; // 0.8 to 1.6m
+            // Game time, so the bounce doesn't depend on the Director running
+            float bounceHeight = 0.8f + std::abs(DeterministicMath::sin(_clock * 10.0f)) * 0.8f; // 0.8 to 1.6m
             
             handPos.y = bounceHeight;
 
@@ -691,3 +714,37 @@ void Player::updateStaminaBar() {
     
     _staminaNode->drawRect(origin, dest, Color4F(0, 0, 0, 1.0f));
 }
+
+void Player::snapshot(Snapshot& out) const {
+    out.state = _state;
+    out.hasBall = _hasBall;
+    out.shootChargeTime = _shootChargeTime;
+    out.isChargingShot = _isChargingShot;
+    out.recoveryTimer = _recoveryTimer;
+    out.celebrationTimer = _celebrationTimer;
+    out.pickupCooldown = _pickupCooldown;
+    out.mustClearBall = _mustClearBall;
+    out.stamina = _stamina;
+    out.clock = _clock;
+    out.facing = _visualNode->getRotation3D();
+    _shootingSystem->snapshot(out.shooting);
+    _dribbleSystem->snapshot(out.dribble);
+    _defenseSystem->snapshot(out.defense);
+}
+
+void Player::restore(const Snapshot& snapshot) {
+    _state = snapshot.state;
+    _hasBall = snapshot.hasBall;
+    _shootChargeTime = snapshot.shootChargeTime;
+    _isChargingShot = snapshot.isChargingShot;
+    _recoveryTimer = snapshot.recoveryTimer;
+    _celebrationTimer = snapshot.celebrationTimer;
+    _pickupCooldown = snapshot.pickupCooldown;
+    _mustClearBall = snapshot.mustClearBall;
+    _stamina = snapshot.stamina;
+    _clock = snapshot.clock;
+    _visualNode->setRotation3D(snapshot.facing);
+    _shootingSystem->restore(snapshot.shooting);
+    _dribbleSystem->restore(snapshot.dribble);
+    _defenseSystem->restore(snapshot.defense);
+}
@@ -5,15 +5,18 @@
 #include "RigidBody.h"
 #include "PlayerController.h"
 #include "Basketball.h"
+#include "ShootingSystem.h"
+#include "DribbleSystem.h"
+#include "DefenseSystem.h"
 
-class ShootingSystem;
-class DribbleSystem;
-class DefenseSystem;
+class CollisionSystem;
 
 class Player : public cocos2d::Node {
 public:
     static Player* create();
+    static Player* create(CollisionSystem* world);
     virtual bool init() override;
+    bool init(CollisionSystem* world);
     virtual ~Player();
     
     // Core Logic
@@ -52,6 +55,7 @@ public:
     
     // Physics
     RigidBody* getBody() const { return _body; }
+    CollisionSystem* getWorld() const { return _world; } // For scene queries
     void setPosition3D(const cocos2d::Vec3& pos) override;
     cocos2d::Vec3 getPosition3D() const override;
     
@@ -79,8 +83,30 @@ public:
     // Limbs Access
     cocos2d::Sprite3D* getModel() const { return _model; }
 
+    // Gameplay state, for replay keyframes. The body is in the world's
+    // snapshot, so restore the world after the players.
+    struct Snapshot {
+        State state;
+        bool hasBall;
+        float shootChargeTime;
+        bool isChargingShot;
+        float recoveryTimer;
+        float celebrationTimer;
+        float pickupCooldown;
+        bool mustClearBall;
+        float stamina;
+        float clock;
+        cocos2d::Vec3 facing;   // _visualNode's rotation, which places the hands
+        ShootingSystem::Snapshot shooting;
+        DribbleSystem::Snapshot dribble;
+        DefenseSystem::Snapshot defense;
+    };
+    void snapshot(Snapshot& out) const;
+    void restore(const Snapshot& snapshot);
+
 private:
     RigidBody* _body;
+    CollisionSystem* _world;
     PlayerController* _controller;
     Basketball* _ball;
     
@@ -114,6 +140,7 @@ private:
     float _pickupCooldown;
     bool _mustClearBall;
     float _stamina;
+    float _clock; // Game time accumulated in update(), drives the dribble bounce
     
     // Helpers
     void handleMovement(float dt);
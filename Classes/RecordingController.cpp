@@ -0,0 +1,66 @@
+#include "RecordingController.h"
+
+USING_NS_CC;
+
+RecordingController::RecordingController(PlayerController* source, InputLog* log, InputLog::Side side)
+    : _source(source)
+    , _log(log)
+    , _side(side)
+    , _hasFrame(false)
+{
+}
+
+RecordingController::~RecordingController() {
+}
+
+const InputFrame& RecordingController::current() {
+    if (!_hasFrame) {
+        // Player::setController only sets our target
+        if (_source->getTarget() != _player) _source->setTarget(_player);
+
+        _frame = InputFrame::capture(_source);
+        _log->append(_side, _frame);
+        _hasFrame = true;
+    }
+    return _frame;
+}
+
+void RecordingController::update(float dt) {
+    // Player calls this last thing in its tick. Log a frame even for a tick
+    // that didn't ask for input, so both sides stay one frame per tick.
+    current();
+    _source->update(dt);
+    _hasFrame = false;
+}
+
+Vec2 RecordingController::getMoveInput() {
+    return current().getMove();
+}
+
+bool RecordingController::isSprintPressed() {
+    return current().isPressed(InputFrame::SPRINT);
+}
+
+bool RecordingController::isJumpPressed() {
+    return current().isPressed(InputFrame::JUMP);
+}
+
+bool RecordingController::isShootPressed() {
+    return current().isPressed(InputFrame::SHOOT);
+}
+
+bool RecordingController::isPassPressed() {
+    return current().isPressed(InputFrame::PASS);
+}
+
+bool RecordingController::isStealPressed() {
+    return current().isPressed(InputFrame::STEAL);
+}
+
+bool RecordingController::isCrossoverPressed() {
+    return current().isPressed(InputFrame::CROSSOVER);
+}
+
+bool RecordingController::isDefendPressed() {
+    return current().isPressed(InputFrame::DEFEND);
+}
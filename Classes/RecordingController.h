@@ -0,0 +1,41 @@
+#ifndef __RECORDING_CONTROLLER_H__
+#define __RECORDING_CONTROLLER_H__
+
+#include "PlayerController.h"
+#include "InputLog.h"
+
+// Drives a player with another controller's input and writes it to an
+// InputLog, one frame per tick. The source is polled once per tick, on the
+// first query (or in update() if the tick made none), and every query that
+// tick answers from that frame, so the game plays exactly what was logged.
+class RecordingController : public PlayerController {
+public:
+    // Doesn't own 'source' or 'log'
+    RecordingController(PlayerController* source, InputLog* log, InputLog::Side side);
+    virtual ~RecordingController();
+
+    virtual void update(float dt) override;
+
+    virtual cocos2d::Vec2 getMoveInput() override;
+    virtual bool isSprintPressed() override;
+    virtual bool isJumpPressed() override;
+    virtual bool isShootPressed() override;
+    virtual bool isPassPressed() override;
+    virtual bool isStealPressed() override;
+    virtual bool isCrossoverPressed() override;
+    virtual bool isDefendPressed() override;
+
+    PlayerController* getSource() const { return _source; }
+
+private:
+    PlayerController* _source;
+    InputLog* _log;
+    InputLog::Side _side;
+
+    InputFrame _frame;
+    bool _hasFrame; // This tick's frame has been polled and logged
+
+    const InputFrame& current();
+};
+
+#endif // __RECORDING_CONTROLLER_H__
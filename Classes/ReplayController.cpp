@@ -0,0 +1,70 @@
+#include "ReplayController.h"
+
+USING_NS_CC;
+
+ReplayController::ReplayController(const InputLog* log, InputLog::Side side)
+    : _log(log)
+    , _side(side)
+    , _finished(false)
+{
+    advance();
+}
+
+ReplayController::~ReplayController() {
+}
+
+void ReplayController::advance() {
+    if (_finished) return;
+    if (!_log->read(_side, _cursor, _frame)) {
+        _frame = InputFrame();
+        _finished = true;
+    }
+}
+
+void ReplayController::update(float dt) {
+    advance();
+}
+
+void ReplayController::snapshot(Snapshot& out) const {
+    out.cursor = _cursor;
+    out.frame = _frame;
+    out.finished = _finished;
+}
+
+void ReplayController::restore(const Snapshot& snapshot) {
+    _cursor = snapshot.cursor;
+    _frame = snapshot.frame;
+    _finished = snapshot.finished;
+}
+
+Vec2 ReplayController::getMoveInput() {
+    return _frame.getMove();
+}
+
+bool ReplayController::isSprintPressed() {
+    return _frame.isPressed(InputFrame::SPRINT);
+}
+
+bool ReplayController::isJumpPressed() {
+    return _frame.isPressed(InputFrame::JUMP);
+}
+
+bool ReplayController::isShootPressed() {
+    return _frame.isPressed(InputFrame::SHOOT);
+}
+
+bool ReplayController::isPassPressed() {
+    return _frame.isPressed(InputFrame::PASS);
+}
+
+bool ReplayController::isStealPressed() {
+    return _frame.isPressed(InputFrame::STEAL);
+}
+
+bool ReplayController::isCrossoverPressed() {
+    return _frame.isPressed(InputFrame::CROSSOVER);
+}
+
+bool ReplayController::isDefendPressed() {
+    return _frame.isPressed(InputFrame::DEFEND);
+}
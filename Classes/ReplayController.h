@@ -0,0 +1,48 @@
+#ifndef __REPLAY_CONTROLLER_H__
+#define __REPLAY_CONTROLLER_H__
+
+#include "PlayerController.h"
+#include "InputLog.h"
+
+// Drives a player from one side of an InputLog: each tick answers with that
+// tick's recorded frame. Past the end of the log it holds no input.
+class ReplayController : public PlayerController {
+public:
+    // Doesn't own 'log', which must outlive the controller
+    ReplayController(const InputLog* log, InputLog::Side side);
+    virtual ~ReplayController();
+
+    // Moves on to the next tick's frame
+    virtual void update(float dt) override;
+
+    virtual cocos2d::Vec2 getMoveInput() override;
+    virtual bool isSprintPressed() override;
+    virtual bool isJumpPressed() override;
+    virtual bool isShootPressed() override;
+    virtual bool isPassPressed() override;
+    virtual bool isStealPressed() override;
+    virtual bool isCrossoverPressed() override;
+    virtual bool isDefendPressed() override;
+
+    bool isFinished() const { return _finished; }
+
+    // Position in the log, for playback keyframes
+    struct Snapshot {
+        InputLog::Cursor cursor;
+        InputFrame frame;
+        bool finished;
+    };
+    void snapshot(Snapshot& out) const;
+    void restore(const Snapshot& snapshot);
+
+private:
+    const InputLog* _log;
+    InputLog::Side _side;
+    InputLog::Cursor _cursor;
+    InputFrame _frame;
+    bool _finished;
+
+    void advance();
+};
+
+#endif // __REPLAY_CONTROLLER_H__
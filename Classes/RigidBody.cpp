@@ -1,5 +1,8 @@
 #include "RigidBody.h"
 #include "SimplePhysics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 RigidBody::RigidBody(ColliderType type, int categoryMask, int collisionMask)
     : _type(type)
@@ -17,20 +20,133 @@ RigidBody::RigidBody(ColliderType type, int categoryMask, int collisionMask)
     , _height(0.0f)
     , _normal(cocos2d::Vec3::UNIT_Y)
     , _planeConstant(0.0f)
+    , _halfExtents(cocos2d::Vec3::ZERO)
+    , _ringRadius(0.0f)
     , _userData(nullptr)
+    , _node(nullptr)
+    , _store(nullptr)
+    , _handle(BodyStore::INVALID_HANDLE)
 {
+    _boxAxes[0] = cocos2d::Vec3::UNIT_X;
+    _boxAxes[1] = cocos2d::Vec3::UNIT_Y;
+    _boxAxes[2] = cocos2d::Vec3::UNIT_Z;
 }
 
 RigidBody::~RigidBody() {
+    detach();
+}
+
+void RigidBody::attach(BodyStore* store) {
+    if (_store == store) return;
+    detach();
+
+    _store = store;
+    _handle = store->create(this);
+
+    size_t i = store->indexOf(_handle);
+    store->posX[i] = _position.x; store->posY[i] = _position.y; store->posZ[i] = _position.z;
+    store->prevX[i] = _previousPosition.x; store->prevY[i] = _previousPosition.y; store->prevZ[i] = _previousPosition.z;
+    store->velX[i] = _velocity.x; store->velY[i] = _velocity.y; store->velZ[i] = _velocity.z;
+    store->forceX[i] = _force.x; store->forceY[i] = _force.y; store->forceZ[i] = _force.z;
+    store->invMass[i] = _invMass;
+    store->restitution[i] = _material.restitution;
+    store->node[i] = _node;
+    syncShape();
+}
+
+void RigidBody::detach() {
+    if (!_store) return;
+
+    // Pull the simulated state back before giving up the slot
+    _position = getPosition();
+    _velocity = getVelocity();
+    size_t i = _store->indexOf(_handle);
+    _previousPosition = cocos2d::Vec3(_store->prevX[i], _store->prevY[i], _store->prevZ[i]);
+    _force = cocos2d::Vec3(_store->forceX[i], _store->forceY[i], _store->forceZ[i]);
+
+    _store->destroy(_handle);
+    _store = nullptr;
+    _handle = BodyStore::INVALID_HANDLE;
+}
+
+uint8_t RigidBody::computeFlags() const {
+    uint8_t flags = 0;
+    if (_isStatic) flags |= BodyStore::FLAG_STATIC;
+    if (_isKinematic) flags |= BodyStore::FLAG_KINEMATIC;
+    if (_type == ColliderType::PLANE) flags |= BodyStore::FLAG_UNBOUNDED;
+
+    // Simple floor handling (hardcoded for the basketball court)
+    if (_type == ColliderType::SPHERE && _categoryMask == SimplePhysics::MASK_BALL) {
+        flags |= BodyStore::FLAG_FLOOR_BOUNCE; // Ball center is its position
+        flags |= BodyStore::FLAG_CCD;          // Small and fast: swept instead of sub-stepped
+    } else if ((_type == ColliderType::SPHERE || _type == ColliderType::CAPSULE) && _categoryMask == SimplePhysics::MASK_PLAYER) {
+        flags |= BodyStore::FLAG_FLOOR_CLAMP;  // Player origin is at the feet
+    }
+    return flags;
+}
+
+cocos2d::Vec3 RigidBody::computeExtents() const {
+    if (_type == ColliderType::CAPSULE) return cocos2d::Vec3(_radius, _height * 0.5f + _radius, _radius);
+    if (_type == ColliderType::BOX) {
+        // Projection of the rotated box onto the world axes
+        cocos2d::Vec3 e;
+        for (int k = 0; k < 3; ++k) {
+            const cocos2d::Vec3& axis = _boxAxes[k];
+            float h = k == 0 ? _halfExtents.x : (k == 1 ? _halfExtents.y : _halfExtents.z);
+            e.x += std::abs(axis.x) * h;
+            e.y += std::abs(axis.y) * h;
+            e.z += std::abs(axis.z) * h;
+        }
+        return e;
+    }
+    if (_type == ColliderType::TORUS) return cocos2d::Vec3(_ringRadius + _radius, _radius, _ringRadius + _radius);
+    return cocos2d::Vec3(_radius, _radius, _radius);
+}
+
+void RigidBody::syncShape() {
+    if (!_store) return;
+    size_t i = _store->indexOf(_handle);
+    uint8_t flags = computeFlags();
+    if ((flags | _store->flags[i]) & BodyStore::FLAG_STATIC) {
+        _store->markStaticChanged();
+    }
+    _store->radius[i] = _radius;
+    cocos2d::Vec3 extents = computeExtents();
+    _store->extentX[i] = extents.x;
+    _store->extentY[i] = extents.y;
+    _store->extentZ[i] = extents.z;
+    _store->flags[i] = flags | (_store->flags[i] & BodyStore::FLAG_SLEEPING);
+    _store->wake(i);
+
+    bool isStatic = (flags & BodyStore::FLAG_STATIC) != 0;
+    bool isKinematic = (flags & BodyStore::FLAG_KINEMATIC) != 0;
+    _store->dynamicMask[i] = (isStatic || isKinematic) ? 0.0f : 1.0f;
+    _store->movableMask[i] = isStatic ? 0.0f : 1.0f;
+
+    if (flags & BodyStore::FLAG_FLOOR_BOUNCE) {
+        _store->floorLevel[i] = SimplePhysics::FLOOR_Y + _radius;
+        _store->floorBounce[i] = -0.7f;  // Restitution
+        _store->floorFriction[i] = 0.95f;
+    } else if (flags & BodyStore::FLAG_FLOOR_CLAMP) {
+        _store->floorLevel[i] = SimplePhysics::FLOOR_Y;
+        _store->floorBounce[i] = 0.0f;
+        _store->floorFriction[i] = 1.0f;
+    } else {
+        _store->floorLevel[i] = -1.0e30f; // Never below
+        _store->floorBounce[i] = 1.0f;
+        _store->floorFriction[i] = 1.0f;
+    }
 }
 
 void RigidBody::setSphere(float radius) {
     _radius = radius;
+    syncShape();
 }
 
 void RigidBody::setCapsule(float radius, float height) {
     _radius = radius;
     _height = height;
+    syncShape();
 }
 
 void RigidBody::setPlane(const cocos2d::Vec3& normal, float constant) {
@@ -38,28 +154,112 @@ void RigidBody::setPlane(const cocos2d::Vec3& normal, float constant) {
     _normal.normalize();
     _planeConstant = constant;
     _isStatic = true; // Planes are usually static
+    syncShape();
+}
+
+void RigidBody::setBox(const cocos2d::Vec3& halfExtents, const cocos2d::Quaternion& rotation) {
+    _halfExtents = halfExtents;
+    cocos2d::Mat4 m;
+    cocos2d::Mat4::createRotation(rotation, &m);
+    _boxAxes[0] = cocos2d::Vec3::UNIT_X;
+    _boxAxes[1] = cocos2d::Vec3::UNIT_Y;
+    _boxAxes[2] = cocos2d::Vec3::UNIT_Z;
+    for (auto& axis : _boxAxes) {
+        m.transformVector(&axis);
+        axis.normalize();
+    }
+    // Thinnest dimension: used to pick substep counts near the box
+    _radius = std::min(halfExtents.x, std::min(halfExtents.y, halfExtents.z));
+    syncShape();
+}
+
+void RigidBody::setTorus(float ringRadius, float tubeRadius) {
+    _ringRadius = ringRadius;
+    _radius = tubeRadius;
+    syncShape();
 }
 
 void RigidBody::setPosition(const cocos2d::Vec3& pos) {
-    _position = pos;
-    // Do NOT update previousPosition here, it's used for interpolation and updated in update()
+    // Do NOT update previousPosition here, it's used for interpolation and updated in integration
+    if (!_store) {
+        _position = pos;
+        return;
+    }
+    size_t i = _store->indexOf(_handle);
+    if (_store->posX[i] == pos.x && _store->posY[i] == pos.y && _store->posZ[i] == pos.z) return;
+    _store->posX[i] = pos.x; _store->posY[i] = pos.y; _store->posZ[i] = pos.z;
+    _store->wake(i);
+    if (_isStatic) _store->markStaticChanged();
+}
+
+cocos2d::Vec3 RigidBody::getPosition() const {
+    if (!_store) return _position;
+    size_t i = _store->indexOf(_handle);
+    return cocos2d::Vec3(_store->posX[i], _store->posY[i], _store->posZ[i]);
+}
+
+void RigidBody::setNode(cocos2d::Node* node) {
+    _node = node;
+    if (!_store) return;
+    size_t i = _store->indexOf(_handle);
+    _store->node[i] = node;
+    _store->nodeX[i] = std::numeric_limits<float>::quiet_NaN(); // Write on the next sync
 }
 
 cocos2d::Vec3 RigidBody::getInterpolatedPosition(float alpha) const {
     // alpha is 0..1, where 1 is current, 0 is previous
-    return _previousPosition * (1.0f - alpha) + _position * alpha;
+    if (!_store) return _previousPosition * (1.0f - alpha) + _position * alpha;
+    size_t i = _store->indexOf(_handle);
+    cocos2d::Vec3 prev(_store->prevX[i], _store->prevY[i], _store->prevZ[i]);
+    cocos2d::Vec3 pos(_store->posX[i], _store->posY[i], _store->posZ[i]);
+    return prev * (1.0f - alpha) + pos * alpha;
 }
 
 void RigidBody::setVelocity(const cocos2d::Vec3& vel) {
-    _velocity = vel;
+    if (!_store) {
+        _velocity = vel;
+        return;
+    }
+    size_t i = _store->indexOf(_handle);
+    if (_store->velX[i] == vel.x && _store->velY[i] == vel.y && _store->velZ[i] == vel.z) return;
+    _store->velX[i] = vel.x; _store->velY[i] = vel.y; _store->velZ[i] = vel.z;
+    _store->wake(i);
+}
+
+cocos2d::Vec3 RigidBody::getVelocity() const {
+    if (!_store) return _velocity;
+    size_t i = _store->indexOf(_handle);
+    return cocos2d::Vec3(_store->velX[i], _store->velY[i], _store->velZ[i]);
 }
 
 void RigidBody::applyForce(const cocos2d::Vec3& force) {
-    _force += force;
+    if (!_store) {
+        _force += force;
+        return;
+    }
+    size_t i = _store->indexOf(_handle);
+    _store->forceX[i] += force.x; _store->forceY[i] += force.y; _store->forceZ[i] += force.z;
+    if (force.x != 0.0f || force.y != 0.0f || force.z != 0.0f) _store->wake(i);
+}
+
+void RigidBody::wakeUp() {
+    if (_store) _store->wake(_store->indexOf(_handle));
+}
+
+bool RigidBody::isSleeping() const {
+    return _store && _store->isSleeping(_store->indexOf(_handle));
 }
 
 void RigidBody::clearForces() {
     _force = cocos2d::Vec3::ZERO;
+    if (!_store) return;
+    size_t i = _store->indexOf(_handle);
+    _store->forceX[i] = 0.0f; _store->forceY[i] = 0.0f; _store->forceZ[i] = 0.0f;
+}
+
+void RigidBody::setMaterial(const SimplePhysicsMaterial& material) {
+    _material = material;
+    if (_store) _store->restitution[_store->indexOf(_handle)] = material.restitution;
 }
 
 void RigidBody::setMass(float mass) {
@@ -69,88 +269,28 @@ void RigidBody::setMass(float mass) {
     } else {
         _invMass = 0.0f;
     }
+    if (_store) _store->invMass[_store->indexOf(_handle)] = _invMass;
+}
+
+void RigidBody::setKinematic(bool kinematic) {
+    _isKinematic = kinematic;
+    syncShape();
+}
+
+void RigidBody::setStatic(bool isStatic) {
+    _isStatic = isStatic;
+    syncShape();
 }
 
 cocos2d::AABB RigidBody::getAABB() const {
-    if (_type == ColliderType::SPHERE) {
-        return cocos2d::AABB(
-            _position - cocos2d::Vec3(_radius, _radius, _radius),
-            _position + cocos2d::Vec3(_radius, _radius, _radius)
-        );
-    } else if (_type == ColliderType::CAPSULE) {
-        float halfHeight = _height * 0.5f;
-        return cocos2d::AABB(
-            _position - cocos2d::Vec3(_radius, halfHeight + _radius, _radius),
-            _position + cocos2d::Vec3(_radius, halfHeight + _radius, _radius)
-        );
-    } else if (_type == ColliderType::PLANE) {
+    if (_type == ColliderType::PLANE) {
         // Return a very large AABB for the plane
         return cocos2d::AABB(
             cocos2d::Vec3(-1000, -100, -1000),
             cocos2d::Vec3(1000, 100, 1000)
         );
     }
-    return cocos2d::AABB();
-}
-
-void RigidBody::update(float dt) {
-    if (_isStatic) return;
-
-    _previousPosition = _position;
-
-    if (!_isKinematic) {
-        // Symplectic Euler
-        // v += (f/m) * dt
-        // x += v * dt
-        
-        cocos2d::Vec3 acceleration = _force * _invMass;
-        _velocity += acceleration * dt;
-    }
-    
-    _position += _velocity * dt;
-
-    // Simple Floor Collision (Hardcoded for basketball court)
-    // Assume Floor at Y = 0
-    float floorY = SimplePhysics::FLOOR_Y;
-    float bottomY = _position.y;
-    
-    // Calculate bottom based on collider type
-    if (_type == ColliderType::SPHERE || _type == ColliderType::CAPSULE) {
-        // For Capsule, origin is usually center, so bottom is pos.y - (halfHeight + radius)
-        // But the game seems to use simpler physics where pos.y is the pivot? 
-        // Let's assume position is the center of mass.
-        
-        // Wait, looking at SimplePhysics::checkCollision, it uses sphere-sphere.
-        // Let's look at Player initialization or visual node. 
-        // Usually 0 is feet.
-        // If 0 is feet, then pos.y < 0 is penetration.
-        // If 0 is center, then pos.y < radius is penetration.
-        
-        // Given SimplePhysics::PLAYER_JUMP_SPEED logic (y < 1.0f is ground),
-        // it seems position is at feet level (0.0 when on ground).
-        // Let's assume position.y IS the bottom for now, or very close to it.
-        // Actually, let's use the radius to be safe if it's a ball.
-        
-        if (_type == ColliderType::SPHERE && _categoryMask == SimplePhysics::MASK_BALL) {
-             // Ball center is its position
-             if (_position.y < floorY + _radius) {
-                 _position.y = floorY + _radius;
-                 // Bounce
-                 if (_velocity.y < 0) {
-                     _velocity.y *= -0.7f; // Restitution
-                     // Friction
-                     _velocity.x *= 0.95f;
-                     _velocity.z *= 0.95f;
-                 }
-             }
-        } else if (_categoryMask == SimplePhysics::MASK_PLAYER) {
-            // Player origin is likely at feet (0,0,0)
-            if (_position.y < floorY) {
-                _position.y = floorY;
-                if (_velocity.y < 0) _velocity.y = 0;
-            }
-        }
-    }
-    
-    clearForces();
+    cocos2d::Vec3 p = getPosition();
+    cocos2d::Vec3 extent = computeExtents();
+    return cocos2d::AABB(p - extent, p + extent);
 }
@@ -3,13 +3,20 @@
 
 #include "cocos2d.h"
 #include "PhysicsMaterial.h"
+#include "BodyStore.h"
 
 enum class ColliderType {
     SPHERE,
     CAPSULE,
-    PLANE
+    PLANE,
+    BOX,    // Oriented box, for static geometry (backboard)
+    TORUS   // Horizontal ring around the body's position (rim)
 };
+const int COLLIDER_TYPE_COUNT = (int)ColliderType::TORUS + 1;
 
+// Thin facade over a BodyStore slot. While attached to a world, the simulated
+// state (position, velocity, force) lives in the store's arrays; otherwise it
+// is kept locally. Properties that rarely change are written through to both.
 class RigidBody {
 public:
     RigidBody(ColliderType type, int categoryMask, int collisionMask);
@@ -19,31 +26,38 @@ public:
     void setSphere(float radius);
     void setCapsule(float radius, float height);
     void setPlane(const cocos2d::Vec3& normal, float constant); // Plane equation: normal.dot(p) + constant = 0
+    void setBox(const cocos2d::Vec3& halfExtents, const cocos2d::Quaternion& rotation = cocos2d::Quaternion::identity());
+    void setTorus(float ringRadius, float tubeRadius); // getRadius() is the tube radius
 
     // Physics State
     void setPosition(const cocos2d::Vec3& pos);
-    cocos2d::Vec3 getPosition() const { return _position; }
+    cocos2d::Vec3 getPosition() const;
     cocos2d::Vec3 getInterpolatedPosition(float alpha) const;
-    
+
     void setVelocity(const cocos2d::Vec3& vel);
-    cocos2d::Vec3 getVelocity() const { return _velocity; }
-    
+    cocos2d::Vec3 getVelocity() const;
+
     void applyForce(const cocos2d::Vec3& force);
     void clearForces();
 
+    // Sleeping (see CollisionSystem). Changing position, velocity, forces or
+    // the body type wakes the body up.
+    void wakeUp();
+    bool isSleeping() const;
+
     // Material
-    void setMaterial(const SimplePhysicsMaterial& material) { _material = material; }
+    void setMaterial(const SimplePhysicsMaterial& material);
     const SimplePhysicsMaterial& getMaterial() const { return _material; }
 
     // Properties
     void setMass(float mass);
     float getMass() const { return _mass; }
     float getInvMass() const { return _invMass; }
-    
-    void setKinematic(bool kinematic) { _isKinematic = kinematic; }
+
+    void setKinematic(bool kinematic);
     bool isKinematic() const { return _isKinematic; }
-    
-    void setStatic(bool isStatic) { _isStatic = isStatic; }
+
+    void setStatic(bool isStatic);
     bool isStatic() const { return _isStatic; }
 
     // Collision
@@ -51,45 +65,72 @@ public:
     int getCategoryMask() const { return _categoryMask; }
     int getCollisionMask() const { return _collisionMask; }
     cocos2d::AABB getAABB() const;
-    
+
     // Specific shape data getters
     float getRadius() const { return _radius; }
     float getHeight() const { return _height; }
     cocos2d::Vec3 getNormal() const { return _normal; }
     float getPlaneConstant() const { return _planeConstant; }
-    
+    const cocos2d::Vec3& getHalfExtents() const { return _halfExtents; }
+    const cocos2d::Vec3& getBoxAxis(int axis) const { return _boxAxes[axis]; } // World space, unit length
+    float getRingRadius() const { return _ringRadius; }
+
+    // Scene node moved to the body's interpolated position after each physics
+    // update (CollisionSystem::syncNodes). Kinematic bodies are left to their owner.
+    void setNode(cocos2d::Node* node);
+    cocos2d::Node* getNode() const { return _node; }
+
     // User Data (e.g., binding to Sprite3D)
     void setUserData(void* data) { _userData = data; }
     void* getUserData() const { return _userData; }
 
+    // Called after the frame's physics (CollisionSystem::dispatchEvents) with
+    // the normal impulse the solver accumulated on the contact. Not called
+    // for contacts resolved while this body was kinematic.
     std::function<void(RigidBody* other, float impulse)> onCollision;
 
-    void update(float dt);
+    // Storage binding (called by CollisionSystem::addBody / removeBody)
+    void attach(BodyStore* store);
+    void detach();
+    BodyStore* getStore() const { return _store; }
+    BodyStore::Handle getHandle() const { return _handle; }
 
 private:
     ColliderType _type;
     int _categoryMask;
     int _collisionMask;
-    
+
+    // Local state, authoritative only while detached
     cocos2d::Vec3 _position;
     cocos2d::Vec3 _previousPosition;
     cocos2d::Vec3 _velocity;
     cocos2d::Vec3 _force;
-    
+
     float _mass;
     float _invMass;
     SimplePhysicsMaterial _material;
-    
+
     bool _isKinematic;
     bool _isStatic;
-    
+
     // Shape data
     float _radius;
     float _height; // For Capsule (total height)
     cocos2d::Vec3 _normal; // For Plane
     float _planeConstant; // For Plane
-    
+    cocos2d::Vec3 _halfExtents; // For Box
+    cocos2d::Vec3 _boxAxes[3];  // For Box (rotated X, Y, Z)
+    float _ringRadius;          // For Torus (center of the tube)
+
     void* _userData;
+    cocos2d::Node* _node;
+
+    BodyStore* _store;
+    BodyStore::Handle _handle;
+
+    uint8_t computeFlags() const;
+    cocos2d::Vec3 computeExtents() const;
+    void syncShape();
 };
 
 #endif // __RIGID_BODY_H__
@@ -2,7 +2,7 @@
 #include "SaveSystem.h"
 #include "GameFeedback.h"
 
-ScoreManager* ScoreManager::_instance = nullptr;
+thread_local ScoreManager* ScoreManager::_instance = nullptr;
 
 ScoreManager* ScoreManager::getInstance() {
     if (!_instance) {
@@ -68,6 +68,22 @@ void ScoreManager::loadState(int pScore, int aiScore, float time, int quarter) {
     _currentQuarter = quarter;
 }
 
+void ScoreManager::snapshot(Snapshot& out) const {
+    out.playerScore = _playerScore;
+    out.aiScore = _aiScore;
+    out.gameTime = _gameTime;
+    out.shotClock = _shotClock;
+    out.currentQuarter = _currentQuarter;
+}
+
+void ScoreManager::restore(const Snapshot& snapshot) {
+    _playerScore = snapshot.playerScore;
+    _aiScore = snapshot.aiScore;
+    _gameTime = snapshot.gameTime;
+    _shotClock = snapshot.shotClock;
+    _currentQuarter = snapshot.currentQuarter;
+}
+
 void ScoreManager::addScore(bool isPlayer, int points) {
     if (isPlayer) {
         _playerScore += points;
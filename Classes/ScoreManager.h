@@ -29,12 +29,23 @@ public:
 
     // Load State
     void loadState(int pScore, int aiScore, float time, int quarter);
+
+    // Everything, shot clock included, for replay keyframes
+    struct Snapshot {
+        int playerScore;
+        int aiScore;
+        float gameTime;
+        float shotClock;
+        int currentQuarter;
+    };
+    void snapshot(Snapshot& out) const;
+    void restore(const Snapshot& snapshot);
     
 private:
     ScoreManager();
     ~ScoreManager();
     
-    static ScoreManager* _instance;
+    static thread_local ScoreManager* _instance; // One per thread, like MatchManager
     
     int _playerScore;
     int _aiScore;
@@ -5,6 +5,8 @@
 #include "AudioManager.h"
 #include "SoundBank.h"
 #include "GameFeedback.h"
+#include "DeterministicMath.h"
+#include "MatchManager.h"
 #include <algorithm>
 #include "base/CCDirector.h"
 #include "2d/CCCamera.h"
@@ -111,7 +113,7 @@ void ShootingSystem::releaseShot() {
             if (dot > 1.0f) dot = 1.0f;
             if (dot < -1.0f) dot = -1.0f;
             
-            float angleRad = acos(dot);
+            float angleRad = DeterministicMath::acos(dot);
             params.defenderAngle = CC_RADIANS_TO_DEGREES(angleRad);
         }
         
@@ -125,7 +127,7 @@ void ShootingSystem::releaseShot() {
     params.timingDev = std::abs(_currentChargeTime - _optimalChargeTime);
     
     // Calculate Result
-    ShotResult result = ShotCalculator::calculateShot(params);
+    ShotResult result = ShotCalculator::calculateShot(params, MatchManager::getInstance()->getRandom().shots());
 
     // --- 100% Accuracy Logic for Open Shots ---
     // User Request: 100% hit rate when unmanned and within range
@@ -247,3 +249,19 @@ Vec3 ShootingSystem::calculateVelocity(const Vec3& startPos, const Vec3& targetP
     
     return Vec3(dir.x * v_h, vy, dir.y * v_h);
 }
+
+void ShootingSystem::snapshot(Snapshot& out) const {
+    out.isCharging = _isCharging;
+    out.currentChargeTime = _currentChargeTime;
+    out.optimalChargeTime = _optimalChargeTime;
+    out.lastFeedback = _lastFeedback;
+    out.feedbackTimer = _feedbackTimer;
+}
+
+void ShootingSystem::restore(const Snapshot& snapshot) {
+    _isCharging = snapshot.isCharging;
+    _currentChargeTime = snapshot.currentChargeTime;
+    _optimalChargeTime = snapshot.optimalChargeTime;
+    _lastFeedback = snapshot.lastFeedback;
+    _feedbackTimer = snapshot.feedbackTimer;
+}
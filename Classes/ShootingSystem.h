@@ -22,6 +22,17 @@ public:
     float getCurrentChargeTime() const { return _currentChargeTime; }
     float getOptimalChargeTime() const { return _optimalChargeTime; }
     std::string getLastFeedback() const { return _lastFeedback; }
+
+    // For Player::Snapshot
+    struct Snapshot {
+        bool isCharging;
+        float currentChargeTime;
+        float optimalChargeTime;
+        std::string lastFeedback;
+        float feedbackTimer;
+    };
+    void snapshot(Snapshot& out) const;
+    void restore(const Snapshot& snapshot);
     
     // Visualization
     void drawTrajectory(cocos2d::DrawNode* debugNode);
@@ -3,6 +3,8 @@
 
 #include "cocos2d.h"
 #include "SimplePhysics.h"
+#include "MatchRandom.h"
+#include "DeterministicMath.h"
 
 enum class ShotType {
     JUMP_SHOT,
@@ -32,7 +34,7 @@ struct ShotResult {
 
 class ShotCalculator {
 public:
-    static ShotResult calculateShot(const ShotParams& params) {
+    static ShotResult calculateShot(const ShotParams& params, RandomStream& random) {
         ShotResult result;
         result.success = false;
         
@@ -79,8 +81,8 @@ public:
             // 0 deg (Front) = 1.0, 90 deg (Side) = 0.5, 180 deg (Back) = 0.1
             // Use Cosine interpolation
             // defenderAngle is in degrees
-            float rad = params.defenderAngle * M_PI / 180.0f;
-            float cosVal = std::cos(rad); // 1.0 at 0, -1.0 at 180
+            float rad = params.defenderAngle * DeterministicMath::PI / 180.0f;
+            float cosVal = DeterministicMath::cos(rad); // 1.0 at 0, -1.0 at 180
             // Map -1..1 to 0..1 (Back..Front) -> No, Back is low interference.
             // Let's use max(0, cosVal) for strict front cone?
             // Or (cosVal + 1) / 2 for full range?
@@ -149,7 +151,7 @@ public:
         result.finalChance = finalChance;
         
         // 4. Success Check
-        result.success = (cocos2d::RandomHelper::random_real(0.0f, 1.0f) < finalChance);
+        result.success = (random.nextFloat() < finalChance);
         
         // 5. Feedback
         if (params.timingDev < 0.1f) result.feedback = "PERFECT";
@@ -186,8 +188,8 @@ public:
             // Or better, let caller handle target calculation? No, calculator should do it.
             
             // Simple random miss
-            float xOffset = cocos2d::RandomHelper::random_real(-1.0f, 1.0f) * missMargin;
-            float zOffset = cocos2d::RandomHelper::random_real(-1.0f, 1.0f) * missMargin;
+            float xOffset = random.range(-1.0f, 1.0f) * missMargin;
+            float zOffset = random.range(-1.0f, 1.0f) * missMargin;
             
             result.targetPos = hoopPos + cocos2d::Vec3(xOffset, 0, zOffset);
             
@@ -213,7 +215,7 @@ public:
     static bool shouldBankShot(const cocos2d::Vec3& shooterPos, const cocos2d::Vec3& hoopPos) {
         // Angle check: ~45 degrees from baseline
         cocos2d::Vec2 toHoop(shooterPos.x - hoopPos.x, shooterPos.z - hoopPos.z);
-        float angle = std::abs(atan2(toHoop.y, toHoop.x) * 180.0f / M_PI); // 0 is +X (Side), 90 is +Z (Center court)
+        float angle = std::abs(DeterministicMath::atan2(toHoop.y, toHoop.x) * 180.0f / DeterministicMath::PI); // 0 is +X (Side), 90 is +Z (Center court)
         // Hoop is at -Z. Shooter is usually at +Z relative to hoop.
         
         // Correct vector: Hoop to Shooter
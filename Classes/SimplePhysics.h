@@ -29,7 +29,31 @@ namespace SimplePhysics {
     
     // Physics Simulation Constants
     constexpr float FIXED_TIME_STEP = 1.0f / 60.0f;
-    constexpr int SUB_STEPS = 4; // Higher sub-steps for better stability (especially fast ball)
+    constexpr int SUB_STEPS = 1; // Fast balls are swept (CCD) instead of sub-stepped
+    
+    // Continuous collision: balls moving more than this fraction of their
+    // radius in one step are swept against everything they could hit
+    constexpr float CCD_MOTION_THRESHOLD = 0.25f;
+    constexpr float CCD_SKIN = 0.005f; // Stop this far inside contact so the narrowphase sees it
+    
+    // Adaptive substeps: a body about to reach a static collider is split into
+    // enough steps to move at most the smaller of both radii per step
+    constexpr int MAX_BODY_SUBSTEPS = 4;
+    
+    // Contact solver
+    constexpr int SOLVER_ITERATIONS = 4;
+    constexpr float CONTACT_CORRECTION = 0.8f;     // Fraction of penetration pushed out per step
+    constexpr float CONTACT_SLOP = 0.01f;          // Penetration left alone
+    constexpr float RESTITUTION_VELOCITY = 0.5f;   // Slower impacts don't bounce
+    constexpr float WARM_START_NORMAL_DOT = 0.9f;  // Reuse last step's impulse only if the normal barely turned
+    
+    // Narrowphase is split across the worker pool above this many pairs per substep
+    constexpr size_t PARALLEL_NARROWPHASE_MIN_PAIRS = 512;
+    
+    // Sleeping: bodies (and everything they touch) slower than this for
+    // SLEEP_TIME seconds stop being simulated until woken
+    constexpr float SLEEP_LINEAR_VELOCITY = 0.15f;
+    constexpr float SLEEP_TIME = 0.5f;
     
     // Helper method declarations
     // Simple sphere-sphere collision check
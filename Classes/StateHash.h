@@ -0,0 +1,39 @@
+#ifndef __STATE_HASH_H__
+#define __STATE_HASH_H__
+
+#include "cocos2d.h"
+#include <cstdint>
+#include <cstring>
+
+// Running 64-bit hash of simulation state, for checking that two runs (or
+// two builds) stay bit-identical tick by tick. Floats are hashed by their
+// bits, so any difference at all, even -0 vs 0, changes the hash.
+class StateHash {
+public:
+    StateHash() : _hash(0xcbf29ce484222325ull) {}
+
+    // FNV-1a over 32-bit words
+    void addBits(uint32_t bits) { _hash = (_hash ^ bits) * 0x100000001b3ull; }
+    void addU64(uint64_t value) { addBits((uint32_t)value); addBits((uint32_t)(value >> 32)); }
+    void addInt(int value) { addBits((uint32_t)value); }
+    void addBool(bool value) { addBits(value ? 1u : 0u); }
+    void addFloat(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        addBits(bits);
+    }
+    void addVec3(const cocos2d::Vec3& v) { addFloat(v.x); addFloat(v.y); addFloat(v.z); }
+
+    // Finalized (SplitMix64), so nearby states give unrelated values
+    uint64_t get() const {
+        uint64_t z = _hash;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t _hash;
+};
+
+#endif // __STATE_HASH_H__
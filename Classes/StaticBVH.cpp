@@ -0,0 +1,95 @@
+#include "StaticBVH.h"
+#include <algorithm>
+
+void StaticBVH::clear() {
+    _nodes.clear();
+    _items.clear();
+}
+
+void StaticBVH::build(const std::vector<cocos2d::AABB>& boxes, const std::vector<int>& ids) {
+    clear();
+    if (boxes.empty()) return;
+
+    _items.resize(boxes.size());
+    for (size_t k = 0; k < boxes.size(); ++k) {
+        _items[k].box = boxes[k];
+        _items[k].center = (boxes[k]._min + boxes[k]._max) * 0.5f;
+        _items[k].id = ids[k];
+    }
+
+    _nodes.reserve(2 * boxes.size());
+    buildNode(0, (int)_items.size());
+}
+
+int StaticBVH::buildNode(int first, int count) {
+    int index = (int)_nodes.size();
+    _nodes.push_back(Node());
+
+    cocos2d::AABB bounds = _items[first].box;
+    for (int k = first + 1; k < first + count; ++k) {
+        bounds.merge(_items[k].box);
+    }
+
+    if (count <= LEAF_SIZE) {
+        Node& leaf = _nodes[index];
+        leaf.box = bounds;
+        leaf.left = leaf.right = -1;
+        leaf.first = first;
+        leaf.count = count;
+        return index;
+    }
+
+    // Median split along the longest axis of the bounds
+    cocos2d::Vec3 size = bounds._max - bounds._min;
+    int axis = 0;
+    if (size.y > size.x) axis = 1;
+    if (size.z > (axis == 0 ? size.x : size.y)) axis = 2;
+
+    int half = count / 2;
+    std::nth_element(_items.begin() + first, _items.begin() + first + half, _items.begin() + first + count,
+        [axis](const Item& a, const Item& b) {
+            float ca = axis == 0 ? a.center.x : (axis == 1 ? a.center.y : a.center.z);
+            float cb = axis == 0 ? b.center.x : (axis == 1 ? b.center.y : b.center.z);
+            // Ties go by id so the tree doesn't depend on the nth_element implementation
+            return ca < cb || (ca == cb && a.id < b.id);
+        });
+
+    int left = buildNode(first, half);
+    int right = buildNode(first + half, count - half);
+
+    // _nodes may have reallocated during recursion
+    Node& node = _nodes[index];
+    node.box = bounds;
+    node.left = left;
+    node.right = right;
+    node.first = 0;
+    node.count = 0;
+    return index;
+}
+
+int StaticBVH::query(const cocos2d::AABB& box, std::vector<int>& out) const {
+    if (_nodes.empty()) return 0;
+
+    int tests = 0;
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = _nodes[stack[--top]];
+        if (!node.box.intersects(box)) continue;
+
+        if (node.count > 0) {
+            for (int k = node.first; k < node.first + node.count; ++k) {
+                tests++;
+                if (_items[k].box.intersects(box)) {
+                    out.push_back(_items[k].id);
+                }
+            }
+        } else {
+            stack[top++] = node.right;
+            stack[top++] = node.left;
+        }
+    }
+    return tests;
+}
@@ -0,0 +1,44 @@
+#ifndef __STATIC_BVH_H__
+#define __STATIC_BVH_H__
+
+#include "cocos2d.h"
+#include <vector>
+
+// Bounding volume hierarchy over colliders that never move (hoop, post...).
+// Built once when the static set changes, then only queried.
+// Nodes live in a flat array; leaves hold up to LEAF_SIZE items.
+class StaticBVH {
+public:
+    static const int LEAF_SIZE = 2;
+
+    // ids[k] is reported by queries for boxes[k]
+    void build(const std::vector<cocos2d::AABB>& boxes, const std::vector<int>& ids);
+    void clear();
+    bool empty() const { return _nodes.empty(); }
+
+    // Appends the ids of all items whose box overlaps 'box'.
+    // Returns the number of item box tests performed.
+    int query(const cocos2d::AABB& box, std::vector<int>& out) const;
+
+private:
+    struct Node {
+        cocos2d::AABB box;
+        int left;   // Child node indices (internal nodes)
+        int right;
+        int first;  // Item range (leaves, count > 0)
+        int count;
+    };
+
+    struct Item {
+        cocos2d::AABB box;
+        cocos2d::Vec3 center;
+        int id;
+    };
+
+    std::vector<Node> _nodes;
+    std::vector<Item> _items;
+
+    int buildNode(int first, int count);
+};
+
+#endif // __STATIC_BVH_H__
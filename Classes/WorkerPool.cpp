@@ -0,0 +1,98 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+const int WorkerPool::MAX_THREADS;
+WorkerPool* WorkerPool::_instance = nullptr;
+
+WorkerPool* WorkerPool::getInstance() {
+    if (!_instance) {
+        _instance = new WorkerPool();
+    }
+    return _instance;
+}
+
+void WorkerPool::destroyInstance() {
+    delete _instance;
+    _instance = nullptr;
+}
+
+WorkerPool::WorkerPool()
+    : _generation(0)
+    , _pending(0)
+    , _quit(false)
+    , _job(nullptr)
+    , _context(nullptr)
+    , _count(0)
+{
+    // Leave one core to the render thread / OS
+    int cores = (int)std::thread::hardware_concurrency();
+    int threads = std::max(0, std::min(MAX_THREADS, cores - 1) - 1);
+    _threads.reserve(threads);
+    for (int k = 0; k < threads; ++k) {
+        _threads.push_back(std::thread(&WorkerPool::workerLoop, this, k + 1));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _wake.notify_all();
+    for (auto& t : _threads) {
+        t.join();
+    }
+}
+
+void WorkerPool::runSlice(int slice) {
+    size_t slices = (size_t)getWorkerCount();
+    size_t begin = _count * slice / slices;
+    size_t end = _count * (slice + 1) / slices;
+    if (begin < end) {
+        _job(_context, slice, begin, end);
+    }
+}
+
+void WorkerPool::dispatch(size_t count, JobFn job, void* context) {
+    if (count == 0) return;
+    if (_threads.empty()) {
+        job(context, 0, 0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = job;
+        _context = context;
+        _count = count;
+        _pending = (int)_threads.size();
+        _generation++;
+    }
+    _wake.notify_all();
+
+    runSlice(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _pending == 0; });
+}
+
+void WorkerPool::workerLoop(int slice) {
+    unsigned seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this, seen] { return _quit || _generation != seen; });
+            if (_quit) return;
+            seen = _generation;
+        }
+
+        runSlice(slice);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            last = --_pending == 0;
+        }
+        if (last) _done.notify_one();
+    }
+}
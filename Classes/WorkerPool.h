@@ -0,0 +1,61 @@
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// Fixed set of threads for splitting physics passes across cores.
+// parallelFor cuts [0, count) into one contiguous slice per worker (the
+// calling thread takes slice 0) and returns once every slice is done, so
+// callers can merge per-slice results in slice order and stay deterministic.
+// Dispatch does not allocate.
+class WorkerPool {
+public:
+    static const int MAX_THREADS = 8;   // Including the calling thread
+
+    static WorkerPool* getInstance();
+    static void destroyInstance();
+
+    // Number of slices parallelFor splits work into (1 on single-core machines)
+    int getWorkerCount() const { return (int)_threads.size() + 1; }
+
+    // fn(slice, begin, end) is called once per non-empty slice
+    template <typename Fn>
+    void parallelFor(size_t count, Fn& fn) {
+        dispatch(count, &invoke<Fn>, &fn);
+    }
+
+private:
+    typedef void (*JobFn)(void* context, int slice, size_t begin, size_t end);
+
+    WorkerPool();
+    ~WorkerPool();
+
+    static WorkerPool* _instance;
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    unsigned _generation;       // Bumped per job; workers run once per change
+    int _pending;               // Worker slices still running
+    bool _quit;
+
+    JobFn _job;
+    void* _context;
+    size_t _count;
+
+    template <typename Fn>
+    static void invoke(void* context, int slice, size_t begin, size_t end) {
+        (*static_cast<Fn*>(context))(slice, begin, end);
+    }
+
+    void dispatch(size_t count, JobFn job, void* context);
+    void runSlice(int slice);
+    void workerLoop(int slice);
+};
+
+#endif // __WORKER_POOL_H__
@@ -0,0 +1,306 @@
+// Headless match runner: plays AI-vs-AI matches without a window, across
+// every core, and streams the results as JSON lines.
+//
+//   nba2k_sim [--matches N] [--threads T] [--seed S] [--out FILE] [--verify]
+//             [--home D,...] [--away D,...]             D: easy|normal|hard
+//             [--home-stats S,...] [--away-stats S,...] S: speed/shooting/defense
+//   nba2k_sim --record FILE [--seed S] [--home D] [--away D] [--home-stats S] [--away-stats S]
+//   nba2k_sim --replay FILE [--seek TICK]
+//   nba2k_sim --bench-snapshot ITERATIONS
+//
+// Every combination of the listed difficulties and stats is a variant, and
+// each variant plays N matches. One line per match as it finishes, then one
+// per variant (win rate, points per possession and shot-clock violations
+// with 95% intervals) and a throughput line. A summary goes to stderr.
+//
+// Each match line carries a hash of the match's state over every tick;
+// builds with NBA2K_DETERMINISTIC give the same hashes for the same seeds.
+// --verify replays every match and exits with 1 if any replay diverged.
+//
+// --record plays one match (the first variant) and writes its InputLog to
+// FILE. --replay plays an InputLog back, whether recorded here or by the
+// game (last_match.nbr in its writable path), checks its checkpoint hashes
+// and exits with 1 if they don't match; --seek then scrubs to TICK.
+//
+// --bench-snapshot times CollisionSystem::snapshot() and restore() on the
+// 1v1 court of a headless match, in that match's own world.
+
+#include "MatchRunner.h"
+#include "MatchReplay.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void usage() {
+    std::fprintf(stderr,
+                 "usage: nba2k_sim [--matches N] [--threads T] [--seed S] [--out FILE] [--verify]\n"
+                 "                 [--home D,...] [--away D,...] [--home-stats S,...] [--away-stats S,...]\n"
+                 "       nba2k_sim --record FILE [--seed S] [--home D] [--away D] [--home-stats S] [--away-stats S]\n"
+                 "       nba2k_sim --replay FILE [--seek TICK]\n"
+                 "       nba2k_sim --bench-snapshot ITERATIONS\n"
+                 "  D: easy|normal|hard    S: speed/shooting/defense, e.g. 50/50/50\n");
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int benchSnapshot(int iterations) {
+    HeadlessMatch::initSharedState();
+
+    // A few seconds in, so bodies are moving and the contact cache is warm
+    HeadlessMatch match;
+    for (int i = 0; i < 300 && match.step(); ++i) {}
+
+    CollisionSystem& world = match.getWorld();
+    CollisionSystem::Snapshot snapshot;
+    world.snapshot(snapshot); // Sizes the buffer
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) world.snapshot(snapshot);
+    double snapshotMicros = secondsSince(start) * 1e6 / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        if (!world.restore(snapshot)) {
+            std::fprintf(stderr, "nba2k_sim: restore failed\n");
+            return 1;
+        }
+    }
+    double restoreMicros = secondsSince(start) * 1e6 / iterations;
+
+    size_t bodies = world.getBodyCount();
+    std::fprintf(stderr, "%zu bodies, %zu bytes per snapshot, %d iterations\n",
+                 bodies, snapshot.getSize(), iterations);
+    std::fprintf(stderr, "snapshot: %.3f us (%.4f us/body)\n", snapshotMicros, snapshotMicros / bodies);
+    std::fprintf(stderr, "restore:  %.3f us (%.4f us/body)\n", restoreMicros, restoreMicros / bodies);
+    return 0;
+}
+
+static int recordMatch(const HeadlessMatch::Config& config, const char* path) {
+    HeadlessMatch::initSharedState();
+
+    InputLog log;
+    HeadlessMatch match(config);
+    match.startRecording(&log);
+    const HeadlessMatch::Result& result = match.run();
+
+    if (!log.save(path)) {
+        std::fprintf(stderr, "nba2k_sim: cannot write %s\n", path);
+        return 1;
+    }
+    std::fprintf(stderr, "recorded %s: %d ticks (%.1fs), home %d - away %d, %zu bytes, hash %016llx\n",
+                 path, result.ticks, result.gameSeconds, result.homeScore, result.awayScore,
+                 log.getSize(), (unsigned long long)result.stateHash);
+    return 0;
+}
+
+static int replayMatch(const char* path, int seekTick) {
+    InputLog log;
+    if (!log.load(path)) {
+        std::fprintf(stderr, "nba2k_sim: cannot read %s\n", path);
+        return 1;
+    }
+    HeadlessMatch::initSharedState();
+
+    MatchReplay replay(log);
+    auto start = std::chrono::steady_clock::now();
+    replay.playToEnd();
+    double wall = secondsSince(start);
+
+    const HeadlessMatch::Result& result = replay.getMatch().getResult();
+    std::fprintf(stderr, "replayed %s: %d ticks (%.1fs), home %d - away %d, hash %016llx, %.0fx real time\n",
+                 path, result.ticks, result.gameSeconds, result.homeScore, result.awayScore,
+                 (unsigned long long)result.stateHash, wall > 0.0 ? result.gameSeconds / wall : 0.0);
+    std::fprintf(stderr, "checkpoints: %d verified", replay.getCheckpointsVerified());
+    if (replay.getDivergedAt() >= 0) std::fprintf(stderr, ", diverged at tick %d", replay.getDivergedAt());
+    std::fprintf(stderr, "\n");
+
+    if (seekTick >= 0) {
+        start = std::chrono::steady_clock::now();
+        replay.seek(seekTick);
+        wall = secondsSince(start);
+        const HeadlessMatch::Result& at = replay.getMatch().getResult();
+        std::fprintf(stderr, "seek %d: home %d - away %d, tick hash %016llx, %.2f ms\n",
+                     replay.getTick(), at.homeScore, at.awayScore,
+                     (unsigned long long)replay.getMatch().getTickHash(), wall * 1000.0);
+    }
+    return replay.getDivergedAt() >= 0 ? 1 : 0;
+}
+
+static std::vector<std::string> split(const char* list, char separator) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* c = list; ; ++c) {
+        if (*c == separator || *c == '\0') {
+            items.push_back(item);
+            item.clear();
+            if (*c == '\0') break;
+        } else {
+            item += *c;
+        }
+    }
+    return items;
+}
+
+static bool parseDifficulties(const char* list, std::vector<AIBrain::Difficulty>& out) {
+    out.clear();
+    for (const auto& name : split(list, ',')) {
+        if (name == "easy") out.push_back(AIBrain::Difficulty::EASY);
+        else if (name == "normal") out.push_back(AIBrain::Difficulty::NORMAL);
+        else if (name == "hard") out.push_back(AIBrain::Difficulty::HARD);
+        else return false;
+    }
+    return !out.empty();
+}
+
+static bool parseStats(const char* list, std::vector<HeadlessMatch::Side>& out) {
+    out.clear();
+    for (const auto& triple : split(list, ',')) {
+        auto values = split(triple.c_str(), '/');
+        if (values.size() != 3) return false;
+        HeadlessMatch::Side side;
+        side.speed = (float)std::atof(values[0].c_str());
+        side.shooting = (float)std::atof(values[1].c_str());
+        side.defense = (float)std::atof(values[2].c_str());
+        out.push_back(side);
+    }
+    return !out.empty();
+}
+
+int main(int argc, char** argv) {
+    int matches = 1;
+    int threads = 0;
+    uint64_t seed = 1;
+    const char* outPath = nullptr;
+    bool verify = false;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    int seekTick = -1;
+    int benchIterations = 0;
+
+    // Defaults: the line-up BasketballScene plays
+    HeadlessMatch::Config defaults;
+    std::vector<AIBrain::Difficulty> homeDifficulties(1, defaults.home.difficulty);
+    std::vector<AIBrain::Difficulty> awayDifficulties(1, defaults.away.difficulty);
+    std::vector<HeadlessMatch::Side> homeStats(1, defaults.home);
+    std::vector<HeadlessMatch::Side> awayStats(1, defaults.away);
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char* arg = argv[i];
+        const char* value = argv[++i];
+        bool ok = true;
+        if (std::strcmp(arg, "--matches") == 0) {
+            matches = std::atoi(value);
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            threads = std::atoi(value);
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            seed = std::strtoull(value, nullptr, 0);
+        } else if (std::strcmp(arg, "--out") == 0) {
+            outPath = value;
+        } else if (std::strcmp(arg, "--record") == 0) {
+            recordPath = value;
+        } else if (std::strcmp(arg, "--replay") == 0) {
+            replayPath = value;
+        } else if (std::strcmp(arg, "--seek") == 0) {
+            seekTick = std::atoi(value);
+        } else if (std::strcmp(arg, "--bench-snapshot") == 0) {
+            benchIterations = std::atoi(value);
+            ok = benchIterations > 0;
+        } else if (std::strcmp(arg, "--home") == 0) {
+            ok = parseDifficulties(value, homeDifficulties);
+        } else if (std::strcmp(arg, "--away") == 0) {
+            ok = parseDifficulties(value, awayDifficulties);
+        } else if (std::strcmp(arg, "--home-stats") == 0) {
+            ok = parseStats(value, homeStats);
+        } else if (std::strcmp(arg, "--away-stats") == 0) {
+            ok = parseStats(value, awayStats);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage();
+            return 1;
+        }
+    }
+    if (matches < 1 || (recordPath && replayPath)) {
+        usage();
+        return 1;
+    }
+
+    if (benchIterations > 0) return benchSnapshot(benchIterations);
+    if (replayPath) return replayMatch(replayPath, seekTick);
+    if (recordPath) {
+        HeadlessMatch::Config config = defaults;
+        config.home = homeStats[0];
+        config.home.difficulty = homeDifficulties[0];
+        config.away = awayStats[0];
+        config.away.difficulty = awayDifficulties[0];
+        config.seed = seed;
+        return recordMatch(config, recordPath);
+    }
+
+    FILE* out = stdout;
+    if (outPath) {
+        out = std::fopen(outPath, "w");
+        if (!out) {
+            std::fprintf(stderr, "nba2k_sim: cannot write %s\n", outPath);
+            return 1;
+        }
+    }
+
+    MatchRunner runner(threads);
+    runner.setVerify(verify);
+    for (auto homeDifficulty : homeDifficulties) {
+        for (auto awayDifficulty : awayDifficulties) {
+            for (const auto& home : homeStats) {
+                for (const auto& away : awayStats) {
+                    HeadlessMatch::Config config = defaults;
+                    config.home = home;
+                    config.home.difficulty = homeDifficulty;
+                    config.away = away;
+                    config.away.difficulty = awayDifficulty;
+                    runner.addVariant(config);
+                }
+            }
+        }
+    }
+
+    runner.run(matches, seed, out);
+    if (out != stdout) std::fclose(out);
+
+    for (size_t v = 0; v < runner.getVariantCount(); ++v) {
+        const MatchRunner::VariantStats& s = runner.getStats(v);
+        MatchRunner::Estimate win = s.homeWinRate();
+        MatchRunner::Estimate homePPP = s.homePointsPerPossession.estimate();
+        MatchRunner::Estimate awayPPP = s.awayPointsPerPossession.estimate();
+        MatchRunner::Estimate violations = s.shotClockViolations.estimate();
+        std::fprintf(stderr,
+                     "variant %zu: home win %.1f%% [%.1f, %.1f], PPP %.3f vs %.3f, shot clock %.2f/match (%ld matches",
+                     v, win.mean * 100.0, win.low * 100.0, win.high * 100.0,
+                     homePPP.mean, awayPPP.mean, violations.mean, s.matches);
+        if (s.unfinished > 0) std::fprintf(stderr, ", %ld unfinished", s.unfinished);
+        std::fprintf(stderr, ")\n");
+    }
+    double wall = runner.getWallSeconds();
+    std::fprintf(stderr, "%ld matches on %d threads in %.3fs: %.0fx real time, %.2f matches/s/core\n",
+                 runner.getMatchCount(), runner.getThreadCount(), wall,
+                 wall > 0.0 ? runner.getSimulatedSeconds() / wall : 0.0,
+                 runner.getMatchesPerSecondPerCore());
+    if (verify) {
+        std::fprintf(stderr, "verify: %ld of %ld replays diverged\n", runner.getDivergedCount(), runner.getMatchCount());
+        if (runner.getDivergedCount() > 0) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Contact regression checks for the collision system, run by ctest.
+//
+//   nba2k_contact_checks
+//
+// Prints each failing case and a summary line; exits with 1 if any fails.
+
+#include "CollisionSystem.h"
+#include "SimplePhysics.h"
+#include <cstdio>
+
+// A sphere (the ball) or capsule (a player) whose center starts on the
+// backboard's front face, or a hair in front of it, at rest or moving in.
+// The box contact has no normal from the closest point there, and used to
+// drop the contact; the body must come out in front of the board.
+static bool checkBackboardFace(ColliderType type, float offset, float speed) {
+    CollisionSystem* world = CollisionSystem::getInstance();
+    world->reset();
+    float boardY = SimplePhysics::HOOP_HEIGHT + 0.3f;
+    float boardZ = SimplePhysics::HOOP_Z - 0.5f;
+    float halfThickness = 0.025f;
+    RigidBody board(ColliderType::BOX, SimplePhysics::MASK_HOOP, SimplePhysics::MASK_BALL | SimplePhysics::MASK_PLAYER);
+    board.setBox(cocos2d::Vec3(0.9f, 0.525f, halfThickness));
+    board.setStatic(true);
+    board.setPosition(cocos2d::Vec3(0, boardY, boardZ));
+    world->addBody(&board);
+
+    bool sphere = type == ColliderType::SPHERE;
+    RigidBody body(type, sphere ? SimplePhysics::MASK_BALL : SimplePhysics::MASK_PLAYER, SimplePhysics::MASK_HOOP);
+    if (sphere) {
+        body.setSphere(SimplePhysics::BALL_RADIUS);
+    } else {
+        body.setCapsule(0.3f, 1.8f);
+    }
+    float face = boardZ + halfThickness;
+    body.setPosition(cocos2d::Vec3(0, boardY, face + offset));
+    body.setVelocity(cocos2d::Vec3(0, 0, -speed));
+    world->addBody(&body);
+
+    for (int i = 0; i < 20; ++i) world->update(SimplePhysics::FIXED_TIME_STEP);
+    float gap = body.getPosition().z - face;
+    world->removeBody(&body);
+    world->removeBody(&board);
+
+    // Pushed clear of the face, allowing for the contact slop
+    bool ok = gap > body.getRadius() - 2.0f * SimplePhysics::CONTACT_SLOP;
+    if (!ok) {
+        std::fprintf(stderr, "backboard face: %s at +%g moving %g m/s ended %+.4f m from the face\n",
+                     sphere ? "sphere" : "capsule", offset, speed, gap);
+    }
+    return ok;
+}
+
+int main() {
+    int failures = 0;
+    const float offsets[] = { 0.0f, 2e-5f, 9e-5f };
+    const float speeds[] = { 0.0f, 2.0f, 6.0f };
+    for (ColliderType type : { ColliderType::SPHERE, ColliderType::CAPSULE }) {
+        for (float offset : offsets) {
+            for (float speed : speeds) {
+                if (!checkBackboardFace(type, offset, speed)) failures++;
+            }
+        }
+    }
+    std::fprintf(stderr, "contact checks: %d failed\n", failures);
+    return failures > 0 ? 1 : 0;
+}